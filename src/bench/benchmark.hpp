@@ -0,0 +1,86 @@
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace Bench{
+
+    /**
+     * @brief Timing of one benchmark, times are per call in nanoseconds
+     */
+    struct Result{
+        std::string name;
+        size_t iterations = 0; // calls per sample
+        size_t samples = 0;
+        double median = 0;
+        double min = 0;
+        double mean = 0;
+        double stddev = 0;
+    };
+
+    // stops the compiler from optimising away a value that is never used
+    template<typename T>
+    inline void doNotOptimize(const T& value){
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const T* sink;
+        sink = &value;
+#endif
+    }
+
+    /**
+     * @brief Times f, the number of calls per sample is grown until a sample takes at least sampleTime
+     * so fast and slow functions are timed to a similar precision
+     *
+     * @param name name the result is reported under
+     * @param f the function to time, called with no arguments
+     * @param samples number of samples taken once the call count is settled
+     * @param sampleTime shortest sample in seconds
+     * @return Result
+     */
+    template<typename F>
+    Result measure(std::string name, F f, size_t samples = 15, double sampleTime = 0.02){
+        using clock = std::chrono::steady_clock;
+        auto time = [&f](size_t iterations){
+            const auto start = clock::now();
+            for(size_t i = 0; i < iterations; i++){
+                f();
+            }
+            return std::chrono::duration<double>(clock::now() - start).count();
+        };
+
+        // warming up and settling the call count
+        size_t iterations = 1;
+        while(time(iterations) < sampleTime && iterations < (size_t(1) << 40)){
+            iterations *= 2;
+        }
+
+        std::vector<double> perCall(samples);
+        for(size_t i = 0; i < samples; i++){
+            perCall[i] = time(iterations)*1e9/iterations;
+        }
+        std::sort(perCall.begin(), perCall.end());
+
+        Result res;
+        res.name = name;
+        res.iterations = iterations;
+        res.samples = samples;
+        res.median = perCall[samples/2];
+        res.min = perCall.front();
+        for(auto t = perCall.cbegin(); t != perCall.cend(); t++){
+            res.mean += *t/samples;
+        }
+        for(auto t = perCall.cbegin(); t != perCall.cend(); t++){
+            res.stddev += (*t - res.mean)*(*t - res.mean)/samples;
+        }
+        res.stddev = std::sqrt(res.stddev);
+        return res;
+    }
+}
+
+#endif
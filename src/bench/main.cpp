@@ -0,0 +1,174 @@
+#include "benchmark.hpp"
+#include "referenceRocket.hpp"
+#include "simulation.hpp"
+#include "stateArray.hpp"
+#include "RealAtmos.hpp"
+#include "atmosTable.hpp"
+#include "maths.hpp"
+#include "compiledRocket.hpp"
+#include <fmt/core.h>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// usage: farseer_bench [results.json] [filter]
+// every benchmark whose name contains filter is run, results are printed and written as json to results.json if given
+int main(int argc, char **argv){
+    const std::string outPath = argc > 1 ? argv[1] : "";
+    const std::string filter = argc > 2 ? argv[2] : "";
+    std::vector<Bench::Result> results;
+
+    auto run = [&results, &filter](std::string name, auto f){
+        if(name.find(filter) == std::string::npos){
+            return;
+        }
+        auto res = Bench::measure(name, f);
+        fmt::print("{:<40} {:>12.1f} ns {:>10.1f} min {:>8.1f} sd  ({} x {})\n", res.name, res.median, res.min, res.stddev, res.samples, res.iterations);
+        results.push_back(res);
+    };
+
+    // a state partway up the boost, off the rod and pitched over a little so every force is non zero
+    Bench::ReferenceRocket rocket;
+    auto sim = Sim::Sim::create(&rocket, 0.01, "");
+    sim->setTakeoff(true);
+    sim->setOnRod(false);
+    Sim::StateArray state = Sim::defaultStateVector();
+    state[Sim::Zp] = 500;
+    state[Sim::Xv] = 5; state[Sim::Zv] = 150;
+    state[Sim::Theta] = 0.05;
+    state[Sim::dPhi] = 0.1; state[Sim::dTheta] = 0.2;
+    const double time = 1.0;
+
+    // the time is nudged every call so nothing downstream can reuse the last result
+    double t = time;
+    auto nudge = [&t, time](){
+        t = t < time + 1e-3 ? t + 1e-9 : time;
+        return t;
+    };
+
+    // +-----+
+    // | SIM |
+    // +-----+
+    run("Sim::calculate", [&](){
+        Bench::doNotOptimize(sim->calculate(nudge(), state));
+    });
+    run("Sim::RK4Integrate", [&](){
+        Bench::doNotOptimize(sim->RK4Integrate(nudge(), 0.01, &state));
+    });
+    // the adaptive integrator
+    const auto k1 = sim->calculate(time, state);
+    run("Sim::DP45Integrate", [&](){
+        Bench::doNotOptimize(sim->DP45Integrate(time, 0.01, &state, &k1));
+    });
+    run("Sim::solve", [&](){
+        auto flight = Sim::Sim::create(&rocket, 0.01, "");
+        flight->setVerbose(false);
+        Bench::doNotOptimize(flight->solve(Sim::defaultStateVector()));
+    });
+    run("Sim::solve quaternion", [&](){
+        auto flight = Sim::Sim::create(&rocket, 0.01, "");
+        flight->setVerbose(false);
+        flight->setAttitudeRepresentation(Sim::QUATERNION);
+        Bench::doNotOptimize(flight->solve(Sim::defaultStateVector()));
+    });
+
+#ifdef FARSEER_PROFILE
+    // where a whole flight spends its time
+    auto profiled = Sim::Sim::create(&rocket, 0.01, "");
+    profiled->setVerbose(false);
+    profiled->solve(Sim::defaultStateVector());
+    fmt::print("\n{}\n", profiled->profiler().report());
+#endif
+
+    // +------------+
+    // | ATMOSPHERE |
+    // +------------+
+    auto atmos = RealAtmos::RealAtmos::GetInstance();
+    // altitudes spread through the lower and upper atmosphere
+    std::vector<double> altitudes;
+    for(int i = 0; i < 1024; i++){
+        altitudes.push_back(-4e3 + i*(150e3/1024));
+    }
+    size_t a = 0;
+    auto altitude = [&altitudes, &a](){
+        a = (a + 1) % altitudes.size();
+        return altitudes[a];
+    };
+    run("RealAtmos::temperature", [&](){ Bench::doNotOptimize(atmos->temperature(altitude())); });
+    run("RealAtmos::pressure", [&](){ Bench::doNotOptimize(atmos->pressure(altitude())); });
+    run("RealAtmos::density", [&](){ Bench::doNotOptimize(atmos->density(altitude())); });
+    run("RealAtmos::g", [&](){ Bench::doNotOptimize(atmos->g(altitude())); });
+    run("RealAtmos::sound", [&](){ Bench::doNotOptimize(atmos->sound(altitude())); });
+    run("RealAtmos::dynamic_viscosity", [&](){ Bench::doNotOptimize(atmos->dynamic_viscosity(altitude())); });
+    run("RealAtmos::kinematic_viscosity", [&](){ Bench::doNotOptimize(atmos->kinematic_viscosity(altitude())); });
+    run("RealAtmos::properties", [&](){ Bench::doNotOptimize(atmos->properties(altitude())); });
+    auto table = RealAtmos::AtmosTable::create(atmos);
+    run("AtmosTable::properties", [&](){ Bench::doNotOptimize(table->properties(std::min(altitude(), 86e3))); });
+
+    // +-------+
+    // | MATHS |
+    // +-------+
+    double angle = 0;
+    run("Utils::eulerToRotmat", [&](){
+        angle += 1e-3;
+        Bench::doNotOptimize(Utils::eulerToRotmat(angle, 0.5*angle, 0.25*angle));
+    });
+    const Eigen::Matrix3d inertia = rocket.inertia(Sim::FlightState(time, 0, 0, 0, 0, 0));
+    Eigen::Vector3d offset{0.3, 0.01, -0.02};
+    run("Utils::parallel_axis_transform", [&](){
+        offset.x() += 1e-9;
+        Bench::doNotOptimize(Utils::parallel_axis_transform(inertia, offset, 1.3));
+    });
+
+    // +------------+
+    // | COMPONENTS |
+    // +------------+
+    // a body with a row of fins, a motor and a nose, nested as the rocket package builds them
+    auto body = std::make_shared<Bench::ReferencePart>(0.6, 2.3e-3, 1.0, Eigen::Vector3d{0.3, 0, 0});
+    auto nose = std::make_shared<Bench::ReferencePart>(0.2, 2.3e-3, 0.3, Eigen::Vector3d{-0.3, 0, 0});
+    auto motor = std::make_shared<Bench::ReferencePart>(0.4, 0, 0.3, Eigen::Vector3d{0.7, 0, 0}, Eigen::Vector3d{-120, 0, 0});
+    body->addComponent(nose.get());
+    body->addComponent(motor.get());
+    std::vector<std::shared_ptr<Bench::ReferencePart>> fins;
+    for(int i = 0; i < 4; i++){
+        fins.push_back(std::make_shared<Bench::ReferencePart>(0.05, 1e-3, 0.1, Eigen::Vector3d{0.9, 0, 0}));
+        body->addComponent(fins.back().get());
+    }
+    auto compiled = Rocket::CompiledRocket::compile(body);
+    run("CompiledRocket::evaluate", [&](){
+        Bench::doNotOptimize(compiled->evaluate(Sim::FlightState(nudge(), 0.4, 0.05, 0.1, 0.1, 3e6), true));
+    });
+    run("CompiledRocket::compile", [&](){
+        Bench::doNotOptimize(Rocket::CompiledRocket::compile(body));
+    });
+
+    if(!outPath.empty()){
+        nlohmann::json benchmarks = nlohmann::json::array();
+        for(auto res = results.cbegin(); res != results.cend(); res++){
+            benchmarks.push_back({
+                {"name", res->name},
+                {"iterations", res->iterations},
+                {"samples", res->samples},
+                {"median_ns", res->median},
+                {"min_ns", res->min},
+                {"mean_ns", res->mean},
+                {"stddev_ns", res->stddev}
+            });
+        }
+        nlohmann::json out = {
+            {"timestamp", std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count()},
+            {"benchmarks", benchmarks}
+        };
+        std::ofstream file(outPath);
+        if(!file){
+            std::cerr << "could not write results to " << outPath << std::endl;
+            return 1;
+        }
+        file << out.dump(2) << std::endl;
+    }
+    return 0;
+}
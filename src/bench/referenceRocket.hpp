@@ -0,0 +1,144 @@
+#ifndef REFERENCE_ROCKET_H_
+#define REFERENCE_ROCKET_H_
+
+#include "rocketInterface.hpp"
+#include "components/component.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <Eigen/Dense>
+
+namespace Bench{
+
+    /**
+     * @brief A 1.5m, 54mm rocket on a 2s motor, every quantity is a closed form so benchmarks time the sim rather than the rocket
+     * it points along -x as the rocket package does so the sims alignment rotation is exercised
+     */
+    class ReferenceRocket : public Sim::RocketInterface{
+        private:
+            double _burnTime = 2;
+            double _thrust = 120;
+            double _wetMass = 1.6;
+            double _dryMass = 1.3;
+            double _length = 1.5;
+            double _diameter = 0.054;
+
+            inline double burnt(double time) const { return std::clamp(time/_burnTime, 0.0, 1.0); }
+
+        public:
+            virtual Eigen::Vector3d thisWayUp() override { return Eigen::Vector3d{-1,0,0}; }
+
+            virtual double mass(const Sim::FlightState& state) override {
+                return _wetMass - (_wetMass - _dryMass)*burnt(state.time());
+            }
+
+            // the propellant burns from the front so the cm moves forward
+            virtual Eigen::Vector3d cm(const Sim::FlightState& state) override {
+                return Eigen::Vector3d{0.85 - 0.05*burnt(state.time()), 0, 0};
+            }
+
+            // a slender cylinder
+            virtual Eigen::Matrix3d inertia(const Sim::FlightState& state) override {
+                const double m = mass(state);
+                const double r = _diameter/2;
+                const double axial = m*r*r/2;
+                const double lateral = m*(3*r*r + _length*_length)/12;
+                return Eigen::Vector3d{axial, lateral, lateral}.asDiagonal();
+            }
+
+            virtual Eigen::Vector3d thrust(const Sim::FlightState& state) override {
+                return state.time() < _burnTime ? Eigen::Vector3d{-_thrust, 0, 0} : Eigen::Vector3d::Zero();
+            }
+
+            virtual Eigen::Vector3d thrustPosition(const Sim::FlightState& state) override {
+                return Eigen::Vector3d{_length, 0, 0};
+            }
+
+            virtual double referenceArea(const Sim::FlightState& state) override {
+                return std::numbers::pi*_diameter*_diameter/4;
+            }
+
+            virtual double referenceLength(const Sim::FlightState& state) override {
+                return _diameter;
+            }
+
+            // slender body normal force with a linear mach correction
+            virtual double c_n(const Sim::FlightState& state) override {
+                return 12*std::sin(state.alpha())/std::max(std::sqrt(std::abs(1 - state.mach()*state.mach())), 0.3);
+            }
+
+            virtual double c_m(const Sim::FlightState& state) override {
+                return 0;
+            }
+
+            virtual Eigen::Vector3d cp(const Sim::FlightState& state) override {
+                return Eigen::Vector3d{1.1 + 0.02*state.mach(), 0, 0};
+            }
+
+            virtual double c_m_damp_pitch(const Sim::FlightState& state) override {
+                return 0.5*std::abs(state.pitchVel())/(1 + state.mach());
+            }
+
+            virtual double c_m_damp_yaw(const Sim::FlightState& state) override {
+                return 0.5*std::abs(state.yawVel())/(1 + state.mach());
+            }
+
+            // turbulent flat plate skin friction
+            virtual double Cdf(const Sim::FlightState& state) override {
+                const double re = std::max(state.reL()*_length, 1e4);
+                return 0.074/std::pow(re, 0.2)*4*_length/_diameter;
+            }
+
+            virtual double Cdp(const Sim::FlightState& state) override {
+                return 0.1 + 0.15*state.mach()*state.mach();
+            }
+
+            // the motor plume fills the base while burning
+            virtual double Cdb(const Sim::FlightState& state) override {
+                return state.time() < _burnTime ? 0.04 : 0.12;
+            }
+    };
+
+    /**
+     * @brief A component with constant, made up values, used to build trees for timing component aggregation
+     */
+    class ReferencePart : public Rocket::Component{
+        private:
+            double _mass;
+            double _area;
+            double _length;
+            Eigen::Vector3d _thrust;
+
+        protected:
+            virtual json propertiesToJson() override { return json::object(); }
+            virtual void jsonToProperties(json j) override {}
+
+            virtual double mass_this(const FlightState& state) override { return _mass; }
+            virtual Eigen::Vector3d cm_this(const FlightState& state) override { return Eigen::Vector3d{_length/2, 0, 0}; }
+            virtual Eigen::Matrix3d inertia_this(const FlightState& state) override {
+                return Eigen::Vector3d{1e-3*_mass, _mass*_length*_length/12, _mass*_length*_length/12}.asDiagonal();
+            }
+            virtual Eigen::Vector3d thrust_this(const FlightState& state) override { return state.time() < 2 ? _thrust : Eigen::Vector3d::Zero(); }
+            virtual double referenceArea_this(const FlightState& state) override { return _area; }
+            virtual double referenceLength_this(const FlightState& state) override { return _length; }
+            virtual double c_n_this(const FlightState& state) override { return 2*std::sin(state.alpha()); }
+            virtual double c_m_this(const FlightState& state) override { return 0; }
+            virtual Eigen::Vector3d cp_this(const FlightState& state) override { return Eigen::Vector3d{_length/2, 0, 0}; }
+            virtual double c_m_damp_pitch_this(const FlightState& state) override { return 0.1*std::abs(state.pitchVel()); }
+            virtual double c_m_damp_yaw_this(const FlightState& state) override { return 0.1*std::abs(state.yawVel()); }
+            virtual double Cdf_this(const FlightState& state) override { return 0.02; }
+            virtual double Cdp_this(const FlightState& state) override { return 0.05*state.mach(); }
+            virtual double Cdb_this(const FlightState& state) override { return 0.01; }
+
+        public:
+            ReferencePart(double mass, double area, double length, Eigen::Vector3d position, Eigen::Vector3d thrust = Eigen::Vector3d::Zero()) :
+                Component("Reference Part", position), _mass(mass), _area(area), _length(length), _thrust(thrust) {}
+
+            virtual std::string type() override { return Rocket::COMPONENT_NAMES::BODY_TUBE; }
+            virtual std::vector<std::string> allowedComponents() override {
+                return std::vector<std::string>{ Rocket::COMPONENT_NAMES::BODY_TUBE };
+            }
+    };
+}
+
+#endif
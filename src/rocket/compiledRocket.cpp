@@ -0,0 +1,150 @@
+#include "compiledRocket.hpp"
+
+namespace Rocket{
+
+CompiledRocket::CompiledRocket(std::shared_ptr<Component> root){
+    _root = root;
+
+    // depth first walk, each component's offset is its parents offset plus its own position
+    std::vector<Eigen::Vector3d> offsets;
+    std::vector<std::pair<Component*, Eigen::Vector3d>> stack = { {root.get(), root->getPosition()} };
+    while(!stack.empty()){
+        auto [comp, offset] = stack.back();
+        stack.pop_back();
+        _components.push_back(comp);
+        offsets.push_back(offset);
+        auto children = comp->components();
+        // pushed in reverse so children are visited in order
+        for(auto c = children.crbegin(); c != children.crend(); c++){
+            stack.push_back({c->get(), offset + c->get()->getPosition()});
+        }
+    }
+
+    const Eigen::Index n = _components.size();
+    _offsets.resize(3, n);
+    _thrustPositions.resize(3, n);
+    Eigen::ArrayXd areas(n);
+    Eigen::ArrayXd lengths(n);
+    // the reference geometry does not depend on the flight state, so it is sampled once here
+    const FlightState rest = FlightState(0, 0, 0, 0, 0, 0);
+    for(Eigen::Index i = 0; i < n; i++){
+        Component* comp = _components[i];
+        _offsets.col(i) = offsets[i];
+        _thrustPositions.col(i) = offsets[i] + comp->thrustPosition_this();
+        areas(i) = comp->referenceArea_this(rest);
+        lengths(i) = comp->referenceLength_this(rest);
+    }
+
+    // the rocket is referenced to its largest component, usually the widest body tube
+    Eigen::Index largest = 0;
+    if(n > 0){
+        areas.maxCoeff(&largest);
+        _referenceArea = areas(largest);
+        _referenceLength = lengths(largest);
+    }
+    _forceWeights = _referenceArea > 0 ? Eigen::ArrayXd(areas/_referenceArea) : Eigen::ArrayXd::Zero(n);
+    const double referenceMoment = _referenceArea*_referenceLength;
+    _momentWeights = referenceMoment > 0 ? Eigen::ArrayXd(areas*lengths/referenceMoment) : Eigen::ArrayXd::Zero(n);
+
+    _masses.resize(n);
+    _cms.resize(3, n);
+    _inertias.resize(n);
+    _thrusts.resize(3, n);
+    _c_ns.resize(n);
+    _c_ms.resize(n);
+    _cps.resize(3, n);
+    _c_m_damp_pitches.resize(n);
+    _c_m_damp_yaws.resize(n);
+    _Cdfs.resize(n);
+    _Cdps.resize(n);
+    _Cdbs.resize(n);
+}
+
+std::shared_ptr<CompiledRocket> CompiledRocket::compile(std::shared_ptr<Component> root){
+    auto obj = std::shared_ptr<CompiledRocket>(
+        new CompiledRocket(root)
+    );
+    return obj;
+}
+
+Eigen::Vector3d CompiledRocket::gatherMass(const FlightState& state){
+    const Eigen::Index n = size();
+    for(Eigen::Index i = 0; i < n; i++){
+        _masses(i) = _components[i]->mass_this(state);
+        _cms.col(i) = _offsets.col(i) + _components[i]->cm_this(state);
+    }
+    const double mass = _masses.sum();
+    return mass > 0 ? Eigen::Vector3d(_cms*_masses.matrix()/mass) : Eigen::Vector3d::Zero();
+}
+
+const Sim::RocketSnapshot& CompiledRocket::snapshot(const FlightState& state, bool massProperties){
+    if(_lastState && *_lastState == state && (_lastHasMass || !massProperties)){
+        return _last;
+    }
+
+    // gathering every component's values, the only virtual calls made
+    const Eigen::Index n = size();
+    Sim::RocketSnapshot& res = _last;
+    if(massProperties){
+        res.cm = gatherMass(state);
+        for(Eigen::Index i = 0; i < n; i++){
+            _inertias[i] = _components[i]->inertia_this(state);
+        }
+    }
+    for(Eigen::Index i = 0; i < n; i++){
+        Component* comp = _components[i];
+        _thrusts.col(i) = comp->thrust_this(state);
+        _c_ns(i) = comp->c_n_this(state);
+        _c_ms(i) = comp->c_m_this(state);
+        _cps.col(i) = _offsets.col(i) + comp->cp_this(state);
+        _c_m_damp_pitches(i) = comp->c_m_damp_pitch_this(state);
+        _c_m_damp_yaws(i) = comp->c_m_damp_yaw_this(state);
+        _Cdfs(i) = comp->Cdf_this(state);
+        _Cdps(i) = comp->Cdp_this(state);
+        _Cdbs(i) = comp->Cdb_this(state);
+    }
+
+    // mass properties, each components inertia is moved to the rockets cm with the parallel axis theorem
+    res.referenceArea = _referenceArea;
+    res.referenceLength = _referenceLength;
+    if(massProperties){
+        res.mass = _masses.sum();
+        res.inertia = Eigen::Matrix3d::Zero();
+        for(Eigen::Index i = 0; i < n; i++){
+            const Eigen::Vector3d d = _cms.col(i) - res.cm;
+            res.inertia += _inertias[i] + _masses(i)*(d.squaredNorm()*Eigen::Matrix3d::Identity() - d*d.transpose());
+        }
+    } else {
+        res.mass = NAN_D;
+        res.cm = NAN_V3D;
+        res.inertia = NAN_M3D;
+    }
+
+    // thrust acts at the thrust weighted mean of the motors positions
+    res.thrust = _thrusts.rowwise().sum();
+    const Eigen::VectorXd thrustMags = _thrusts.colwise().norm().transpose();
+    const double totalThrust = thrustMags.sum();
+    res.thrustPosition = totalThrust > 0 ? Eigen::Vector3d(_thrustPositions*thrustMags/totalThrust) : Eigen::Vector3d::Zero();
+
+    // aero coefficients are rescaled to the rockets reference geometry and summed, the cp is the normal force weighted mean
+    const Eigen::ArrayXd normalForces = _c_ns*_forceWeights;
+    res.c_n = normalForces.sum();
+    // with no normal force the cp is put at the cm, which is only gathered for this when the mass properties were skipped
+    if(res.c_n != 0){
+        res.cp = _cps*normalForces.matrix()/res.c_n;
+    } else {
+        res.cp = massProperties ? res.cm : gatherMass(state);
+    }
+    res.c_m = (_c_ms*_momentWeights).sum();
+    res.c_m_damp_pitch = (_c_m_damp_pitches*_momentWeights).sum();
+    res.c_m_damp_yaw = (_c_m_damp_yaws*_momentWeights).sum();
+    res.Cdf = (_Cdfs*_forceWeights).sum();
+    res.Cdp = (_Cdps*_forceWeights).sum();
+    res.Cdb = (_Cdbs*_forceWeights).sum();
+
+    _lastState = state;
+    _lastHasMass = massProperties;
+    return res;
+}
+
+}
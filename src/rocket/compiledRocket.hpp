@@ -0,0 +1,110 @@
+#pragma once
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "components/component.hpp"
+#include "rocketInterface.hpp"
+
+namespace Rocket {
+
+/**
+ * A component tree flattened into contiguous arrays for flight.
+ * The tree is walked once when compiled, storing each component's offset from the root along with its reference geometry,
+ * after which every quantity is found from one pass over the arrays instead of a walk of the tree per quantity.
+ * Components still supply their own values through their *_this functions, but the shape of the tree, the positions
+ * and the reference areas and lengths are fixed when compiled, so compile again after editing the tree.
+ */
+class CompiledRocket : public Sim::RocketInterface{
+    private:
+        std::shared_ptr<Component> _root;
+
+        // one entry per component in depth first order, the root first
+        std::vector<Component*> _components;
+        Eigen::Matrix3Xd _offsets; // of each component's origin from the root's origin
+        Eigen::Matrix3Xd _thrustPositions; // relative to the root's origin
+        double _referenceArea = 0;
+        double _referenceLength = 0;
+        // scale each component's coefficients from its own reference geometry to the rocket's
+        Eigen::ArrayXd _forceWeights; // A_i/A_ref
+        Eigen::ArrayXd _momentWeights; // A_i*L_i/(A_ref*L_ref)
+
+        // per component values from the last evaluation
+        Eigen::ArrayXd _masses;
+        Eigen::Matrix3Xd _cms;
+        std::vector<Eigen::Matrix3d> _inertias;
+        Eigen::Matrix3Xd _thrusts;
+        Eigen::ArrayXd _c_ns;
+        Eigen::ArrayXd _c_ms;
+        Eigen::Matrix3Xd _cps;
+        Eigen::ArrayXd _c_m_damp_pitches;
+        Eigen::ArrayXd _c_m_damp_yaws;
+        Eigen::ArrayXd _Cdfs;
+        Eigen::ArrayXd _Cdps;
+        Eigen::ArrayXd _Cdbs;
+
+        // the interface functions are called with the same state one after another, so the last evaluation is kept
+        std::optional<FlightState> _lastState;
+        bool _lastHasMass = false;
+        Sim::RocketSnapshot _last;
+
+        CompiledRocket(std::shared_ptr<Component> root);
+        const Sim::RocketSnapshot& snapshot(const FlightState& state, bool massProperties = true);
+        // fills _masses and _cms, returning the rocket's cm
+        Eigen::Vector3d gatherMass(const FlightState& state);
+
+    public:
+        /**
+         * @brief Flattens the tree below root, the tree is kept alive by the compiled rocket
+         *
+         * @param root the top of the tree, usually the rocket itself
+         * @return std::shared_ptr<CompiledRocket>
+         */
+        static std::shared_ptr<CompiledRocket> compile(std::shared_ptr<Component> root);
+
+        // number of components flattened, including the root
+        inline size_t size() const { return _components.size(); }
+
+        inline std::shared_ptr<Component> root() const { return _root; }
+
+        // +---------------------+
+        // | INTERFACE FUNCTIONS |
+        // +---------------------+
+        virtual Eigen::Vector3d thisWayUp() override { return _root->thisWayUp(); }
+
+        virtual Sim::RocketSnapshot evaluate(const FlightState& state, bool massProperties) override { return snapshot(state, massProperties); }
+
+        virtual double mass(const FlightState& state) override { return snapshot(state).mass; }
+
+        virtual Eigen::Vector3d cm(const FlightState& state) override { return snapshot(state).cm; }
+
+        virtual Eigen::Matrix3d inertia(const FlightState& state) override { return snapshot(state).inertia; }
+
+        virtual Eigen::Vector3d thrust(const FlightState& state) override { return snapshot(state).thrust; }
+
+        virtual Eigen::Vector3d thrustPosition(const FlightState& state) override { return snapshot(state).thrustPosition; }
+
+        virtual double referenceArea(const FlightState& state) override { return _referenceArea; }
+
+        virtual double referenceLength(const FlightState& state) override { return _referenceLength; }
+
+        virtual double c_n(const FlightState& state) override { return snapshot(state).c_n; }
+
+        virtual double c_m(const FlightState& state) override { return snapshot(state).c_m; }
+
+        virtual Eigen::Vector3d cp(const FlightState& state) override { return snapshot(state).cp; }
+
+        virtual double c_m_damp_yaw(const FlightState& state) override { return snapshot(state).c_m_damp_yaw; }
+
+        virtual double c_m_damp_pitch(const FlightState& state) override { return snapshot(state).c_m_damp_pitch; }
+
+        virtual double Cdf(const FlightState& state) override { return snapshot(state).Cdf; }
+
+        virtual double Cdp(const FlightState& state) override { return snapshot(state).Cdp; }
+
+        virtual double Cdb(const FlightState& state) override { return snapshot(state).Cdb; }
+};
+
+}
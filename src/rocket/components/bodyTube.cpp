@@ -1,4 +1,6 @@
 #include "bodyTube.hpp"
+#include <cstdint>
+#include <stdexcept>
 
 namespace Rocket{
 
@@ -54,4 +56,33 @@ void BodyTube::jsonToProperties(json j) {
     ));
 }
 
+void BodyTube::propertiesToSnapshot(SnapshotWriter& out) {
+    out.put(getHeight());
+    out.put(getDiameter());
+    out.put(getThickness());
+    // bools are written as a byte so their representation is fixed
+    out.put<uint8_t>(getFilled());
+    out.putString(getMaterial()->name);
+    out.put(getMaterial()->getDensity());
+    out.putString(getFinish()->name);
+    out.put(getFinish()->getRoughness());
+}
+
+void BodyTube::snapshotToProperties(SnapshotReader& in) {
+    setHeight(in.get<double>());
+    setDiameter(in.get<double>());
+    setThickness(in.get<double>());
+    const uint8_t filled = in.get<uint8_t>();
+    if(filled > 1){
+        throw std::runtime_error("design snapshot has an invalid body tube fill flag");
+    }
+    setFilled(filled == 1);
+    const std::string materialName(in.getString());
+    const double density = in.get<double>();
+    setMaterial(std::make_unique<Material>(materialName, density));
+    const std::string finishName(in.getString());
+    const double roughness = in.get<double>();
+    setFinish(std::make_unique<Finish>(finishName, roughness));
+}
+
 }
\ No newline at end of file
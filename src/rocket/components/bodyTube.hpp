@@ -17,6 +17,8 @@ class BodyTube : public Component{
         virtual json propertiesToJson() override;
         // this will also go about creating sub-components
         virtual void jsonToProperties(json j) override;
+        virtual void propertiesToSnapshot(SnapshotWriter& out) override;
+        virtual void snapshotToProperties(SnapshotReader& in) override;
     
     public:
         BodyTube(
@@ -32,22 +34,23 @@ class BodyTube : public Component{
         );
 
         double getHeight(){ return _height; }
-        void setHeight(double height) { _height = std::max(0.0,height); }
+        void setHeight(double height) { _height = std::max(0.0,height); invalidateCache(); }
         
         double getDiameter(){ return _diameter; }
-        void setDiameter(double diameter) { _diameter = std::max(0.0,diameter); }
+        void setDiameter(double diameter) { _diameter = std::max(0.0,diameter); invalidateCache(); }
 
         double getThickness(){ return _thickness; }
-        void setThickness(double thickness) { _thickness = std::max(0.0,thickness); }
+        void setThickness(double thickness) { _thickness = std::max(0.0,thickness); invalidateCache(); }
 
         bool getFilled(){ return _filled; }
-        void setFilled(bool filled) { _filled = filled; }
+        void setFilled(bool filled) { _filled = filled; invalidateCache(); }
 
+        // the cached flight values are only cleared by the setters, change the material and finish through them rather than in place
         Material* getMaterial() { return _material.get(); }
-        void setMaterial(std::unique_ptr<Material> material) { _material = std::move(material); }
+        void setMaterial(std::unique_ptr<Material> material) { _material = std::move(material); invalidateCache(); }
 
         Finish* getFinish() { return _finish.get(); }
-        void setFinish(std::unique_ptr<Finish> finish) { _finish = std::move(finish); }
+        void setFinish(std::unique_ptr<Finish> finish) { _finish = std::move(finish); invalidateCache(); }
 
         virtual std::string type() override { return COMPONENT_NAMES::BODY_TUBE; };
         virtual std::vector<std::string> allowedComponents() override {
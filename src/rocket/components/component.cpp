@@ -1,11 +1,17 @@
 #include "component.hpp"
+#include <mutex>
 
 namespace Rocket{
 
 UUIDv4::UUIDGenerator<std::mt19937_64> Component::_uuidGenerator = UUIDv4::UUIDGenerator<std::mt19937_64>();
+// components are built on several threads by sweeps and loaders, the generator's engine isn't safe to share unguarded
+static std::mutex uuidMutex;
 
 Component::Component(std::string name, Eigen::Vector3d position){
-    _id = _uuidGenerator.getUUID().str();
+    {
+        std::lock_guard<std::mutex> lock(uuidMutex);
+        _id = _uuidGenerator.getUUID().str();
+    }
     this->name = name;
     setPosition(position);
 }
@@ -49,6 +55,7 @@ bool Component::addComponent( Component* comp ){
     }
     comp->setParent(this);
     _components.push_back(comp->shared_from_this());
+    invalidateCache();
     return true;
 }
 
@@ -68,6 +75,7 @@ bool Component::removeComponent( Component* comp ){
             // component found
             _components.erase(c);
             comp->setParent(nullptr);
+            invalidateCache();
             return true;
         }
     }
@@ -111,6 +119,8 @@ void Component::applyJson(json j){
     std::vector<double> jsonPos = j.at("position");
     setPosition( Eigen::Vector3d {jsonPos[0],jsonPos[1],jsonPos[2]} );
     jsonToProperties(j);
+    // subclasses may set their properties directly rather than through setters that clear the cache
+    invalidateCache();
     // TODO component creation
     std::vector<json> jsonComps = j.at("components");
     for(auto i = jsonComps.cbegin(); i != jsonComps.cend(); i++){
@@ -119,17 +129,100 @@ void Component::applyJson(json j){
     }
 }
 
+std::string Component::toSnapshot(){
+    SnapshotWriter out;
+    for(char c : SNAPSHOT::MAGIC){
+        out.put(c);
+    }
+    out.put(SNAPSHOT::VERSION);
+    writeSnapshot(out);
+    return out.release();
+}
+
+void Component::writeSnapshot(SnapshotWriter& out){
+    const size_t start = out.beginSection();
+    out.putString(type());
+    out.putString(name);
+    out.putVector(getPosition());
+
+    const size_t properties = out.beginSection();
+    propertiesToSnapshot(out);
+    out.endSection(properties);
+
+    out.put<uint64_t>(_components.size());
+    for(auto c = _components.cbegin(); c != _components.cend(); c++){
+        c->get()->writeSnapshot(out);
+    }
+    out.endSection(start);
+}
+
+void Component::applySnapshot(SnapshotReader& in){
+    name = std::string(in.getString());
+    setPosition(in.getVector());
+    SnapshotReader properties = in.section();
+    snapshotToProperties(properties);
+    invalidateCache();
+    const uint64_t count = in.get<uint64_t>();
+    for(uint64_t i = 0; i < count; i++){
+        auto comp = componentFromSnapshot(in);
+        addComponent(comp.get());
+    }
+}
+
+void Component::propertiesToSnapshot(SnapshotWriter& out){
+    const std::vector<uint8_t> cbor = json::to_cbor(propertiesToJson());
+    out.putString(std::string_view(reinterpret_cast<const char*>(cbor.data()), cbor.size()));
+}
+
+void Component::snapshotToProperties(SnapshotReader& in){
+    const std::string_view cbor = in.getString();
+    json properties = json::from_cbor(cbor.begin(), cbor.end());
+    // jsonToProperties takes the whole component json
+    jsonToProperties(json{ {"properties", properties} });
+}
+
 /*************************
  *                       *
  * CALCULATION FUNCTIONS *
  *                       *
  *************************/
+// cache
+Component::CachedValues Component::values_with_components(const FlightState& state){
+    return CachedValues{
+        mass_with_componets(state),
+        cm_with_components(state),
+        inertia_with_components(state),
+        thrust_with_components(state),
+        thrustPosition_with_components(state),
+        referenceArea_with_components(state),
+        referenceLength_with_components(state),
+        c_n_with_components(state),
+        c_m_with_components(state),
+        cp_with_components(state),
+        c_m_damp_pitch_with_components(state),
+        c_m_damp_yaw_with_components(state),
+        Cdf_with_components(state),
+        Cdp_with_components(state),
+        Cdb_with_components(state)
+    };
+}
+
+const Component::CachedValues& Component::cached(const FlightState& state){
+    return _cache.get(state, [this](const FlightState& s){ return values_with_components(s); });
+}
+
+void Component::invalidateCache(){
+    for(Component* comp = this; comp != nullptr; comp = comp->parent()){
+        comp->_cache.clear();
+    }
+}
+
 // mass
 double Component::mass_with_componets(const FlightState& state){
     return 0;
 }
 double Component::mass_with_cache(const FlightState& state){
-    return 0;
+    return cached(state).mass;
 }
 double Component::mass(const FlightState& state){
     return 0;
@@ -140,7 +233,7 @@ Eigen::Vector3d Component::cm_with_components(const FlightState& state){
     return Eigen::Vector3d::Zero();
 }
 Eigen::Vector3d Component::cm_with_cache(const FlightState& state){
-    return Eigen::Vector3d::Zero();
+    return cached(state).cm;
 }
 Eigen::Vector3d Component::cm(const FlightState& state){
     return getPosition();
@@ -151,7 +244,7 @@ Eigen::Matrix3d Component::inertia_with_components(const FlightState& state){
     return Eigen::Matrix3d::Zero();
 }
 Eigen::Matrix3d Component::inertia_with_cache(const FlightState& state){
-    return Eigen::Matrix3d::Zero();
+    return cached(state).inertia;
 }
 Eigen::Matrix3d Component::inertia(const FlightState& state){
     return Eigen::Matrix3d::Zero();
@@ -162,7 +255,7 @@ Eigen::Vector3d Component::thrust_with_components(const FlightState& state){
     return Eigen::Vector3d::Zero();
 }
 Eigen::Vector3d Component::thrust_with_cache(const FlightState& state){
-    return Eigen::Vector3d::Zero();
+    return cached(state).thrust;
 }
 Eigen::Vector3d Component::thrust(const FlightState& state){
     return Eigen::Vector3d::Zero();
@@ -173,7 +266,7 @@ Eigen::Vector3d Component::thrustPosition_with_components(const FlightState& sta
     return Eigen::Vector3d::Zero();
 }
 Eigen::Vector3d Component::thrustPosition_with_cache(const FlightState& state){
-    return Eigen::Vector3d::Zero();
+    return cached(state).thrustPosition;
 }
 Eigen::Vector3d Component::thrustPosition(const FlightState& state){
     return Eigen::Vector3d::Zero();
@@ -184,7 +277,7 @@ double Component::referenceArea_with_components(const FlightState& state){
     return 0;
 }
 double Component::referenceArea_with_cache(const FlightState& state){
-    return 0;
+    return cached(state).referenceArea;
 }
 double Component::referenceArea(const FlightState& state){
     return 0;
@@ -195,7 +288,7 @@ double Component::referenceLength_with_components(const FlightState& state){
     return 0;
 }
 double Component::referenceLength_with_cache(const FlightState& state){
-    return 0;
+    return cached(state).referenceLength;
 }
 double Component::referenceLength(const FlightState& state){
     return 0;
@@ -206,7 +299,7 @@ double Component::c_n_with_components(const FlightState& state){
     return 0;
 }
 double Component::c_n_with_cache(const FlightState& state){
-    return 0;
+    return cached(state).c_n;
 }
 double Component::c_n(const FlightState& state){
     return 0;
@@ -217,7 +310,7 @@ double Component::c_m_with_components(const FlightState& state){
     return 0;
 }
 double Component::c_m_with_cache(const FlightState& state){
-    return 0;
+    return cached(state).c_m;
 }
 double Component::c_m(const FlightState& state){
     return 0;
@@ -228,7 +321,7 @@ Eigen::Vector3d Component::cp_with_components(const FlightState& state){
     return Eigen::Vector3d::Zero();
 }
 Eigen::Vector3d Component::cp_with_cache(const FlightState& state){
-    return Eigen::Vector3d::Zero();
+    return cached(state).cp;
 }
 Eigen::Vector3d Component::cp(const FlightState& state){
     return getPosition();
@@ -239,7 +332,7 @@ double Component::c_m_damp_pitch_with_components(const FlightState& state){
     return 0;
 }
 double Component::c_m_damp_pitch_with_cache(const FlightState& state){
-    return 0;
+    return cached(state).c_m_damp_pitch;
 }
 double Component::c_m_damp_pitch(const FlightState& state){
     return 0;
@@ -250,7 +343,7 @@ double Component::c_m_damp_yaw_with_components(const FlightState& state){
     return 0;
 }
 double Component::c_m_damp_yaw_with_cache(const FlightState& state){
-    return 0;
+    return cached(state).c_m_damp_yaw;
 }
 double Component::c_m_damp_yaw(const FlightState& state){
     return 0;
@@ -261,7 +354,7 @@ double Component::Cdf_with_components(const FlightState& state){
     return 0;
 }
 double Component::Cdf_with_cache(const FlightState& state){
-    return 0;
+    return cached(state).Cdf;
 }
 double Component::Cdf(const FlightState& state){
     return 0;
@@ -272,7 +365,7 @@ double Component::Cdp_with_components(const FlightState& state){
     return 0;
 }
 double Component::Cdp_with_cache(const FlightState& state){
-    return 0;
+    return cached(state).Cdp;
 }
 double Component::Cdp(const FlightState& state){
     return 0;
@@ -283,7 +376,7 @@ double Component::Cdb_with_components(const FlightState& state){
     return 0;
 }
 double Component::Cdb_with_cache(const FlightState& state){
-    return 0;
+    return cached(state).Cdb;
 }
 double Component::Cdb(const FlightState& state){
     return 0;
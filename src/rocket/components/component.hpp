@@ -1,4 +1,5 @@
 #pragma once
+#include <functional>
 #include <memory>
 #include <vector>
 #include <algorithm>
@@ -9,9 +10,10 @@
 #include <uuid_v4/uuid_v4.h>
 #include <nlohmann/json.hpp>
 using json = nlohmann::json;
-#include <lrucache.hpp>
 
 #include "rocketInterface.hpp"
+#include "flightStateMemo.hpp"
+#include "snapshot.hpp"
 using FlightState = Sim::FlightState;
 
 namespace Rocket {
@@ -28,6 +30,8 @@ namespace COMPONENT_NAMES{
 }
 
 class Component : public std::enable_shared_from_this<Component>, public Sim::RocketInterface{
+    // flattens trees of components and evaluates them through the *_this functions
+    friend class CompiledRocket;
     private:
         static UUIDv4::UUIDGenerator<std::mt19937_64> _uuidGenerator;
         std::string _id;
@@ -40,103 +44,114 @@ class Component : public std::enable_shared_from_this<Component>, public Sim::Ro
         virtual json propertiesToJson() = 0;
         // this will also go about creating sub-components
         virtual void jsonToProperties(json j) = 0;
+        // binary counterparts of the two above for design snapshots, by default the properties json is stored as CBOR so every
+        // component can be snapshotted, override both for types loaded often so they skip building json
+        virtual void propertiesToSnapshot(SnapshotWriter& out);
+        virtual void snapshotToProperties(SnapshotReader& in);
 
         // +-------------------------+
         // | INTERFACE SUB-FUNCTIONS |
         // +-------------------------+
-        // first the cache is checked for a calculation at the given time, if not found, the calculation is done and added to the cache
-        // the caches store the values returned by cm_with_components
+        // first the cache is checked for a calculation at the given flight state, if not found every *_with_components value is
+        // calculated in one pass and stored together, so one miss fills the cache for every quantity
         // openrocket makes even heavier use of caching
         // thrust and thustPosition have default implementations as they only really apply to motors
         static const size_t cache_size = 3;
+        struct CachedValues{
+            double mass;
+            Eigen::Vector3d cm;
+            Eigen::Matrix3d inertia;
+            Eigen::Vector3d thrust;
+            Eigen::Vector3d thrustPosition;
+            double referenceArea;
+            double referenceLength;
+            double c_n;
+            double c_m;
+            Eigen::Vector3d cp;
+            double c_m_damp_pitch;
+            double c_m_damp_yaw;
+            double Cdf;
+            double Cdp;
+            double Cdb;
+        };
+        FlightStateMemo<CachedValues, cache_size> _cache;
+        virtual CachedValues values_with_components(const FlightState& state);
+        const CachedValues& cached(const FlightState& state);
+        // clears the cache of this component and everything above it, call when anything they calculate from changes
+        void invalidateCache();
         // mass
         virtual double mass_this(const FlightState& state) = 0;
         virtual double mass_with_componets(const FlightState& state);
-        cache::lru_cache<double, double> mass_cache = cache::lru_cache<double, double>(cache_size);
         virtual double mass_with_cache(const FlightState& state);
 
         // cm
         virtual Eigen::Vector3d cm_this(const FlightState& state) = 0;
         virtual Eigen::Vector3d cm_with_components(const FlightState& state);
-        cache::lru_cache<double, Eigen::Vector3d> cm_cache = cache::lru_cache<double, Eigen::Vector3d>(cache_size);
         virtual Eigen::Vector3d cm_with_cache(const FlightState& state);
         
         // inertia
         virtual Eigen::Matrix3d inertia_this(const FlightState& state) = 0;
         virtual Eigen::Matrix3d inertia_with_components(const FlightState& state);
-        cache::lru_cache<double, Eigen::Matrix3d> inertia_cache = cache::lru_cache<double, Eigen::Matrix3d>(cache_size);
         virtual Eigen::Matrix3d inertia_with_cache(const FlightState& state);
 
         // thrust
         virtual Eigen::Vector3d thrust_this(const FlightState& state){ return Eigen::Vector3d::Zero(); }
         virtual Eigen::Vector3d thrust_with_components(const FlightState& state);
-        cache::lru_cache<double, Eigen::Vector3d> thrust_cache = cache::lru_cache<double, Eigen::Vector3d>(cache_size);
         virtual Eigen::Vector3d thrust_with_cache(const FlightState& state);
 
         // thrustPosition
         virtual Eigen::Vector3d thrustPosition_this(){ return Eigen::Vector3d::Zero(); }
         virtual Eigen::Vector3d thrustPosition_with_components(const FlightState& state);
-        cache::lru_cache<double, Eigen::Vector3d> thrustPosition_cache = cache::lru_cache<double, Eigen::Vector3d>(cache_size);
         virtual Eigen::Vector3d thrustPosition_with_cache(const FlightState& state);
 
         // referenceArea
         virtual double referenceArea_this(const FlightState& state) = 0;
         virtual double referenceArea_with_components(const FlightState& state);
-        cache::lru_cache<double, double> referenceArea_cache = cache::lru_cache<double, double>(cache_size);
         virtual double referenceArea_with_cache(const FlightState& state);
 
         // referenceLength
         virtual double referenceLength_this(const FlightState& state) = 0;
         virtual double referenceLength_with_components(const FlightState& state);
-        cache::lru_cache<double, double> referenceLength_cache = cache::lru_cache<double, double>(cache_size);
         virtual double referenceLength_with_cache(const FlightState& state);
 
         // c_n
         virtual double c_n_this(const FlightState& state) = 0;
         virtual double c_n_with_components(const FlightState& state);
-        cache::lru_cache<double, double> c_n_cache = cache::lru_cache<double, double>(cache_size);
         virtual double c_n_with_cache(const FlightState& state);
 
         // c_m
         virtual double c_m_this(const FlightState& state) = 0;
         virtual double c_m_with_components(const FlightState& state);
-        cache::lru_cache<double, double> c_m_cache = cache::lru_cache<double, double>(cache_size);
         virtual double c_m_with_cache(const FlightState& state);
 
         // cp
         virtual Eigen::Vector3d cp_this(const FlightState& state) = 0;
         virtual Eigen::Vector3d cp_with_components(const FlightState& state);
-        cache::lru_cache<double, Eigen::Vector3d> cp_cache = cache::lru_cache<double, Eigen::Vector3d>(cache_size);
         virtual Eigen::Vector3d cp_with_cache(const FlightState& state);
 
         // c_m_damp_pitch
         virtual double c_m_damp_pitch_this(const FlightState& state) = 0;
         virtual double c_m_damp_pitch_with_components(const FlightState& state);
-        cache::lru_cache<double, double> c_m_damp_pitch_cache = cache::lru_cache<double, double>(cache_size);
         virtual double c_m_damp_pitch_with_cache(const FlightState& state);
 
         // c_m_damp_yaw
         virtual double c_m_damp_yaw_this(const FlightState& state) = 0;
         virtual double c_m_damp_yaw_with_components(const FlightState& state);
-        cache::lru_cache<double, double> c_m_damp_yaw_cache = cache::lru_cache<double, double>(cache_size);
         virtual double c_m_damp_yaw_with_cache(const FlightState& state);
 
         // Cdf
         virtual double Cdf_this(const FlightState& state) = 0;
         virtual double Cdf_with_components(const FlightState& state);
-        cache::lru_cache<double, double> Cdf_cache = cache::lru_cache<double, double>(cache_size);
         virtual double Cdf_with_cache(const FlightState& state);
 
         // Cdp
         virtual double Cdp_this(const FlightState& state) = 0;
         virtual double Cdp_with_components(const FlightState& state);
-        cache::lru_cache<double, double> Cdp_cache = cache::lru_cache<double, double>(cache_size);
         virtual double Cdp_with_cache(const FlightState& state);
 
         // Cdb
         virtual double Cdb_this(const FlightState& state) = 0;
         virtual double Cdb_with_components(const FlightState& state);
-        cache::lru_cache<double, double> Cdb_cache = cache::lru_cache<double, double>(cache_size);
         virtual double Cdb_with_cache(const FlightState& state);
 
     public:
@@ -149,7 +164,7 @@ class Component : public std::enable_shared_from_this<Component>, public Sim::Ro
         std::string name;
 
         Eigen::Vector3d getPosition(){ return _position; };
-        void setPosition(Eigen::Vector3d position){ _position = position; };
+        void setPosition(Eigen::Vector3d position){ _position = position; invalidateCache(); };
 
         std::string id(){ return _id; };
 
@@ -175,6 +190,14 @@ class Component : public std::enable_shared_from_this<Component>, public Sim::Ro
         void applyJson(json j);
         json toJson();
 
+        // Snapshot methods
+        // the tree as a design snapshot, a compact binary form of toJson that loads without building json
+        std::string toSnapshot();
+        // writes this component and its sub-components as one section, type first so the factory can create it
+        void writeSnapshot(SnapshotWriter& out);
+        // applies a component written by writeSnapshot after its type has been read
+        void applySnapshot(SnapshotReader& in);
+
         // +---------------------+
         // | INTERFACE FUNCTIONS |
         // +---------------------+
@@ -216,7 +239,17 @@ class Component : public std::enable_shared_from_this<Component>, public Sim::Ro
         
 };
 
-// definition for this function is in factory.cpp
+// definitions for these functions are in factory.cpp
+// creates an empty component of one type for the loaders to apply properties to
+using ComponentMaker = std::function<std::shared_ptr<Component>()>;
+// makes a type loadable by componentFromJson and componentFromSnapshot, replacing any maker already registered for it
+// registered types are checked before the built in ones so concrete classes can be supplied for them
+void registerComponentType(const std::string& type, ComponentMaker maker);
+// nullptr if the type is not registered or built in
 std::shared_ptr<Component> componentFromJson(json j);
+// nullptr if the snapshot is invalid or its top component is of an unknown type, unknown sub-components are skipped
+std::shared_ptr<Component> componentFromSnapshot(std::string_view snapshot);
+// reads one component section of a snapshot, nullptr if its type is unknown
+std::shared_ptr<Component> componentFromSnapshot(SnapshotReader& in);
 
 }
\ No newline at end of file
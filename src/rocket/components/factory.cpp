@@ -1,10 +1,33 @@
 #include "component.hpp"
 #include "bodyTube.hpp"
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 
 namespace Rocket{
 
-std::shared_ptr<Component> componentFromJson(json j){
-    const std::string type = j.at("component_type");
+// loaders on several threads only read the registry, so they share the lock
+static std::shared_mutex registryMutex;
+static std::unordered_map<std::string, ComponentMaker> registry;
+
+void registerComponentType(const std::string& type, ComponentMaker maker){
+    std::unique_lock<std::shared_mutex> lock(registryMutex);
+    registry[type] = maker;
+}
+
+// an empty component of the type, nullptr if the type is unknown
+static std::shared_ptr<Component> componentFromType(const std::string& type){
+    ComponentMaker maker;
+    {
+        std::shared_lock<std::shared_mutex> lock(registryMutex);
+        auto registered = registry.find(type);
+        if(registered != registry.end()){
+            maker = registered->second;
+        }
+    }
+    if(maker){
+        return maker();
+    }
     std::shared_ptr<Component> comp = nullptr;
 
     // strings dont work with switch statements???
@@ -17,6 +40,12 @@ std::shared_ptr<Component> componentFromJson(json j){
     else {
         comp = nullptr;
     }
+    return comp;
+}
+
+std::shared_ptr<Component> componentFromJson(json j){
+    const std::string type = j.at("component_type");
+    std::shared_ptr<Component> comp = componentFromType(type);
 
     if(comp.get() == nullptr){
         // TODO: ERROR LOGGING
@@ -27,4 +56,36 @@ std::shared_ptr<Component> componentFromJson(json j){
     return comp;
 }
 
+std::shared_ptr<Component> componentFromSnapshot(SnapshotReader& in){
+    // the whole component is read from its own section so an unknown one is skipped along with its sub-components
+    SnapshotReader section = in.section();
+    const std::string type(section.getString());
+    std::shared_ptr<Component> comp = componentFromType(type);
+
+    if(comp.get() == nullptr){
+        return nullptr;
+    }
+    comp->applySnapshot(section);
+
+    return comp;
+}
+
+std::shared_ptr<Component> componentFromSnapshot(std::string_view snapshot){
+    SnapshotReader in(snapshot);
+    try{
+        for(char c : SNAPSHOT::MAGIC){
+            if(in.get<char>() != c){
+                return nullptr;
+            }
+        }
+        if(in.get<uint32_t>() != SNAPSHOT::VERSION){
+            return nullptr;
+        }
+        return componentFromSnapshot(in);
+    } catch(const std::exception&) {
+        // truncated snapshots and malformed properties
+        return nullptr;
+    }
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#include <array>
+#include <optional>
+
+#include "rocketInterface.hpp"
+using FlightState = Sim::FlightState;
+
+namespace Rocket {
+
+// fixed capacity memo keyed on the whole flight state, entries live inline so lookups and inserts never allocate
+// the oldest entry is replaced on a miss, a step only revisits a handful of states so this is as good as lru here
+template<typename Values, size_t Capacity>
+class FlightStateMemo{
+    private:
+        std::array<std::optional<FlightState>, Capacity> _keys;
+        std::array<Values, Capacity> _values;
+        size_t _next = 0;
+
+    public:
+        // returns the values stored for state, calling compute(state) to fill an entry if there are none
+        template<typename F>
+        const Values& get(const FlightState& state, F compute){
+            for(size_t i = 0; i < Capacity; i++){
+                if(_keys[i] && *_keys[i] == state){
+                    return _values[i];
+                }
+            }
+            const size_t slot = _next;
+            _next = (_next + 1) % Capacity;
+            _values[slot] = compute(state);
+            _keys[slot] = state;
+            return _values[slot];
+        }
+
+        void clear(){
+            _keys.fill(std::nullopt);
+            _next = 0;
+        }
+};
+
+}
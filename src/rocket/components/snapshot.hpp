@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <Eigen/Dense>
+
+namespace Rocket{
+
+// design snapshots start with these so other files are rejected rather than misread
+namespace SNAPSHOT{
+    constexpr char MAGIC[8] = { 'F', 'S', 'D', 'S', 'G', 'N', '\0', '\0' };
+    constexpr uint32_t VERSION = 1;
+}
+
+/**
+ * Builds a design snapshot, the compact binary form of a component tree.
+ * Numbers are written as their native bytes so a snapshot is only read back on a machine of the same endianness,
+ * strings and sections are prefixed with their length.
+ */
+class SnapshotWriter{
+    private:
+        std::string _buffer;
+
+    public:
+        template<typename T>
+        inline void put(T value){
+            static_assert(std::is_arithmetic_v<T>, "only numbers are written directly");
+            _buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        inline void putString(std::string_view value){
+            put<uint64_t>(value.size());
+            _buffer.append(value);
+        }
+
+        inline void putVector(const Eigen::Vector3d& value){
+            put(value.x());
+            put(value.y());
+            put(value.z());
+        }
+
+        // reserves the length of a section, returning where it starts for endSection
+        inline size_t beginSection(){
+            put<uint64_t>(0);
+            return _buffer.size();
+        }
+
+        // fills in the length of the section so a reader can skip it whole
+        inline void endSection(size_t start){
+            const uint64_t length = _buffer.size() - start;
+            std::memcpy(_buffer.data() + start - sizeof(length), &length, sizeof(length));
+        }
+
+        inline const std::string& buffer() const { return _buffer; }
+        inline std::string release(){ return std::move(_buffer); }
+};
+
+/**
+ * Reads a design snapshot in place, nothing is copied apart from the values asked for.
+ * Reading past the end of the data throws std::runtime_error.
+ */
+class SnapshotReader{
+    private:
+        std::string_view _data;
+        size_t _position = 0;
+
+        inline void need(uint64_t bytes) const {
+            if(bytes > _data.size() - _position){
+                throw std::runtime_error("design snapshot is truncated");
+            }
+        }
+
+    public:
+        explicit SnapshotReader(std::string_view data) : _data(data) {}
+
+        template<typename T>
+        inline T get(){
+            static_assert(std::is_arithmetic_v<T>, "only numbers are read directly");
+            need(sizeof(T));
+            T value;
+            std::memcpy(&value, _data.data() + _position, sizeof(T));
+            _position += sizeof(T);
+            return value;
+        }
+
+        // a view into the snapshot, copy it to keep it past the snapshot's lifetime
+        inline std::string_view getString(){
+            const uint64_t length = get<uint64_t>();
+            need(length);
+            std::string_view value = _data.substr(_position, length);
+            _position += length;
+            return value;
+        }
+
+        inline Eigen::Vector3d getVector(){
+            const double x = get<double>();
+            const double y = get<double>();
+            const double z = get<double>();
+            return Eigen::Vector3d{x, y, z};
+        }
+
+        // a reader over the next section, which is skipped in this reader whether or not it is read
+        inline SnapshotReader section(){
+            return SnapshotReader(getString());
+        }
+
+        inline bool atEnd() const { return _position == _data.size(); }
+};
+
+}
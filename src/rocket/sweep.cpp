@@ -0,0 +1,227 @@
+#include "sweep.hpp"
+#include "compiledRocket.hpp"
+#include "simulation.hpp"
+#include "threadPool.hpp"
+#include "nanValues.hpp"
+#include <fstream>
+#include <stdexcept>
+
+namespace Rocket{
+
+const char* sweepMetricName(SweepMetric metric){
+    switch(metric){
+        case SweepMetric::Apogee: return "apogee";
+        case SweepMetric::ApogeeTime: return "apogee_time";
+        case SweepMetric::FlightTime: return "flight_time";
+        case SweepMetric::RailExitTime: return "rail_exit_time";
+        case SweepMetric::BurnoutTime: return "burnout_time";
+        case SweepMetric::Steps: return "steps";
+        case SweepMetric::MaxMach: return "max_mach";
+        case SweepMetric::MaxDynamicPressure: return "max_dynamic_pressure";
+        case SweepMetric::RailExitVelocity: return "rail_exit_velocity";
+        case SweepMetric::LandingX: return "landing_x";
+        case SweepMetric::LandingY: return "landing_y";
+        default: return "unknown";
+    }
+}
+
+void SweepResults::writeCsv(const std::filesystem::path& path) const {
+    std::ofstream file(path);
+    if(!file){
+        throw std::runtime_error("could not open " + path.string() + " to write sweep results");
+    }
+    for(size_t c = 0; c < columns.size(); c++){
+        file << (c > 0 ? "," : "") << columns[c];
+    }
+    file << ",error\n";
+    file.precision(10);
+    for(Eigen::Index r = 0; r < values.rows(); r++){
+        for(Eigen::Index c = 0; c < values.cols(); c++){
+            file << (c > 0 ? "," : "") << values(r, c);
+        }
+        // errors are free text so they are quoted
+        std::string error = errors[r];
+        for(size_t i = error.find('"'); i != std::string::npos; i = error.find('"', i + 2)){
+            error.insert(i, "\"");
+        }
+        file << ",\"" << error << "\"\n";
+    }
+}
+
+Sweep::Sweep(
+    std::shared_ptr<Component> base, std::vector<SweepParameter> parameters, Sim::StateArray initialConditions, double timeStep,
+    DesignBuilder builder
+    ){
+    _base = base->toJson();
+    _parameters = parameters;
+    _initialConditions = initialConditions;
+    _timeStep = timeStep;
+
+    // the path to each component in the json, toJson writes children in the order of components()
+    std::unordered_map<std::string, std::string> paths;
+    std::vector<std::pair<Component*, std::string>> stack = { {base.get(), ""} };
+    while(!stack.empty()){
+        auto [comp, path] = stack.back();
+        stack.pop_back();
+        paths[comp->id()] = path;
+        auto children = comp->components();
+        for(size_t i = 0; i < children.size(); i++){
+            stack.push_back({children[i].get(), path + "/components/" + std::to_string(i)});
+        }
+    }
+
+    for(auto p = _parameters.cbegin(); p != _parameters.cend(); p++){
+        auto path = paths.find(p->componentId);
+        if(path == paths.end()){
+            throw std::invalid_argument("sweep parameter " + p->property + " names component " + p->componentId + " which is not in the design");
+        }
+        json::json_pointer pointer(path->second + "/properties/" + p->property);
+        if(!_base.contains(pointer)){
+            throw std::invalid_argument("component " + p->componentId + " has no property " + p->property);
+        }
+        _pointers.push_back(pointer);
+    }
+
+    setDesignBuilder(builder);
+}
+
+std::shared_ptr<Sweep> Sweep::create(
+    std::shared_ptr<Component> base, std::vector<SweepParameter> parameters, Sim::StateArray initialConditions, double timeStep,
+    DesignBuilder builder
+    ){
+    auto obj = std::shared_ptr<Sweep>(
+        new Sweep(base, parameters, initialConditions, timeStep, builder)
+    );
+    return obj;
+}
+
+void Sweep::setDesignBuilder(DesignBuilder builder){
+    if(!builder || builder(_base) == nullptr){
+        throw std::invalid_argument("the base design could not be built from its json, register its component types or pass a design builder");
+    }
+    _builder = builder;
+}
+
+void Sweep::setIntegrator(Sim::IntegrationStrats integrator){
+    if(integrator != Sim::RK4 && integrator != Sim::AB && integrator != Sim::DP45 && integrator != Sim::ABM){
+        throw std::invalid_argument("only RK4, AB, DP45 and ABM integration are supported by solve");
+    }
+    _integrator = integrator;
+}
+
+std::vector<Sweep::Point> Sweep::grid(const std::vector<SweepParameter>& parameters){
+    std::vector<Point> points = { Point{} };
+    for(auto p = parameters.cbegin(); p != parameters.cend(); p++){
+        std::vector<Point> next;
+        next.reserve(points.size()*p->values.size());
+        for(auto point = points.cbegin(); point != points.cend(); point++){
+            for(auto v = p->values.cbegin(); v != p->values.cend(); v++){
+                next.push_back(*point);
+                next.back().push_back(*v);
+            }
+        }
+        points = std::move(next);
+    }
+    return points;
+}
+
+void Sweep::runPoint(const Point& point, const std::vector<SweepMetric>& metrics, SweepResults& results, size_t row) const {
+    const size_t nParams = _parameters.size();
+    for(size_t i = 0; i < nParams; i++){
+        results.values(row, i) = point[i];
+    }
+    try{
+        json design = _base;
+        for(size_t i = 0; i < nParams; i++){
+            design[_pointers[i]] = point[i];
+        }
+        auto tree = _builder(design);
+        if(tree == nullptr){
+            throw std::runtime_error("the design could not be built from its json");
+        }
+        auto rocket = CompiledRocket::compile(tree);
+
+        Sim::Kpis::KpiMask kpis = _kpis;
+        for(auto m = metrics.cbegin(); m != metrics.cend(); m++){
+            switch(*m){
+                case SweepMetric::MaxMach: kpis.set(Sim::Kpis::MaxMach); break;
+                case SweepMetric::MaxDynamicPressure: kpis.set(Sim::Kpis::MaxDynamicPressure); break;
+                case SweepMetric::RailExitVelocity: kpis.set(Sim::Kpis::RailExitVelocity); break;
+                case SweepMetric::LandingX:
+                case SweepMetric::LandingY: kpis.set(Sim::Kpis::LandingPosition); break;
+                default: break;
+            }
+        }
+
+        auto sim = Sim::Sim::create(rocket.get(), _timeStep, std::filesystem::path{});
+        sim->setVerbose(false);
+        sim->setSummaryOnly(true);
+        sim->setRodLen(_rodLength);
+        sim->setIntegrator(_integrator);
+        if(_tolerances){
+            sim->setTolerances(_tolerances->first, _tolerances->second);
+        }
+        sim->setAtmosTable(_atmosTable);
+        sim->setKpis(kpis);
+        sim->solve(_initialConditions);
+
+        const Sim::FlightSummary& summary = sim->summary();
+        if(summary.stepLimited){
+            throw std::runtime_error("the flight reached the step limit before landing");
+        }
+        for(size_t m = 0; m < metrics.size(); m++){
+            double value = NAN_D;
+            switch(metrics[m]){
+                case SweepMetric::Apogee: value = summary.apogee; break;
+                case SweepMetric::ApogeeTime: value = summary.apogeeTime; break;
+                case SweepMetric::FlightTime: value = summary.flightTime; break;
+                case SweepMetric::RailExitTime: value = summary.railExitTime; break;
+                case SweepMetric::BurnoutTime: value = summary.burnoutTime; break;
+                case SweepMetric::Steps: value = summary.steps; break;
+                case SweepMetric::MaxMach: value = summary.maxMach; break;
+                case SweepMetric::MaxDynamicPressure: value = summary.maxDynamicPressure; break;
+                case SweepMetric::RailExitVelocity: value = summary.railExitVelocity; break;
+                case SweepMetric::LandingX: value = summary.landingPosition.x(); break;
+                case SweepMetric::LandingY: value = summary.landingPosition.y(); break;
+            }
+            results.values(row, nParams + m) = value;
+        }
+    } catch(const std::exception& e) {
+        results.values.row(row).tail(metrics.size()).setConstant(NAN_D);
+        results.errors[row] = e.what();
+    }
+}
+
+SweepResults Sweep::run(const std::vector<Point>& points, const std::vector<SweepMetric>& metrics, size_t threads) const {
+    for(auto point = points.cbegin(); point != points.cend(); point++){
+        if(point->size() != _parameters.size()){
+            throw std::invalid_argument("every sweep point needs one value per parameter");
+        }
+    }
+
+    SweepResults results;
+    for(auto p = _parameters.cbegin(); p != _parameters.cend(); p++){
+        results.columns.push_back(p->componentId + "/" + p->property);
+    }
+    for(auto m = metrics.cbegin(); m != metrics.cend(); m++){
+        results.columns.push_back(sweepMetricName(*m));
+    }
+    results.values = Eigen::MatrixXd::Zero(points.size(), _parameters.size() + metrics.size());
+    results.errors.resize(points.size());
+
+    // each point writes only its own row so the table needs no locking
+    Sim::ThreadPool pool(threads);
+    for(size_t i = 0; i < points.size(); i++){
+        pool.submit([this, &points, &metrics, &results, i](){
+            runPoint(points[i], metrics, results, i);
+        });
+    }
+    pool.wait();
+    return results;
+}
+
+SweepResults Sweep::run(const std::vector<SweepMetric>& metrics, size_t threads) const {
+    return run(grid(_parameters), metrics, threads);
+}
+
+}
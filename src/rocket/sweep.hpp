@@ -0,0 +1,153 @@
+#pragma once
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <nlohmann/json.hpp>
+using json = nlohmann::json;
+
+#include "components/component.hpp"
+#include "stateArray.hpp"
+#include "simulation.hpp"
+
+namespace Rocket {
+
+/**
+ * A design variable swept over, a numeric property of one component in the base design
+ */
+struct SweepParameter{
+    std::string componentId;
+    // key in the components "properties" json, nested keys are separated by '/' as in "material/density"
+    std::string property;
+    // values taken when the sweep is run as a grid
+    std::vector<double> values = {};
+};
+
+// what is kept from each flight
+enum class SweepMetric{
+    Apogee,
+    ApogeeTime,
+    FlightTime,
+    RailExitTime,
+    BurnoutTime,
+    Steps,
+    MaxMach,
+    MaxDynamicPressure, // pascals
+    RailExitVelocity, // meters/second
+    // where the flight came down, the landing height is the ground so is not kept
+    LandingX,
+    LandingY
+};
+
+const char* sweepMetricName(SweepMetric metric);
+
+/**
+ * One row per point holding its parameter values then its metrics, points that failed have NaN metrics and an error
+ */
+struct SweepResults{
+    std::vector<std::string> columns;
+    Eigen::MatrixXd values;
+    std::vector<std::string> errors;
+
+    inline size_t size() const { return values.rows(); }
+    inline bool failed(size_t point) const { return !errors[point].empty(); }
+
+    // writes the table with a header row, throws std::runtime_error if the file cannot be written
+    void writeCsv(const std::filesystem::path& path) const;
+};
+
+/**
+ * Flies variations of a base design in parallel.
+ * The base tree is stored as json and each point edits a copy of it, rebuilds the tree, compiles it and flies it with only
+ * the flight summary kept, so points are independent and nothing is written to disk.
+ * Rebuilding needs every component type in the design to be loadable, componentFromJson only builds the types given to
+ * registerComponentType so pass a builder to create otherwise.
+ */
+class Sweep{
+    public:
+        // builds a tree from a designs json, componentFromJson unless replaced
+        using DesignBuilder = std::function<std::shared_ptr<Component>(const json&)>;
+        using Point = std::vector<double>;
+
+    private:
+        json _base;
+        std::vector<SweepParameter> _parameters;
+        std::vector<json::json_pointer> _pointers; // to each parameters value in the base json
+        Sim::StateArray _initialConditions;
+        double _timeStep;
+        double _rodLength = 0.1;
+        DesignBuilder _builder = componentFromJson;
+        // settings handed to each points sim, left at the sims defaults when unset
+        Sim::IntegrationStrats _integrator = Sim::RK4;
+        std::optional<std::pair<Sim::StateArray, Sim::StateArray>> _tolerances; // rtol then atol
+        std::shared_ptr<const RealAtmos::AtmosTable> _atmosTable = nullptr;
+        Sim::Kpis::KpiMask _kpis = Sim::Kpis::allKpis();
+
+        Sweep(
+            std::shared_ptr<Component> base, std::vector<SweepParameter> parameters, Sim::StateArray initialConditions, double timeStep,
+            DesignBuilder builder
+            );
+
+        // flies one point, filling its row of the results
+        void runPoint(const Point& point, const std::vector<SweepMetric>& metrics, SweepResults& results, size_t row) const;
+
+    public:
+        /**
+         * @brief Creates a sweep over a design, a design held as json should be built with componentFromJson first so its components have ids
+         *
+         * @param base the design the parameters are applied to, it is not modified
+         * @param parameters the design variables, each must name a component in base
+         * @param initialConditions the initial conditions of every flight
+         * @param timeStep the user step of every flight
+         * @param builder rebuilds a tree from each points json, it is tried on the base design and std::invalid_argument is
+         * thrown if it cannot build it, so a design that could never fly fails here rather than at every point
+         * @return std::shared_ptr<Sweep>
+         */
+        static std::shared_ptr<Sweep> create(
+            std::shared_ptr<Component> base, std::vector<SweepParameter> parameters, Sim::StateArray initialConditions, double timeStep,
+            DesignBuilder builder = componentFromJson
+            );
+
+        // every combination of the parameters values, the last parameter varies fastest
+        static std::vector<Point> grid(const std::vector<SweepParameter>& parameters);
+
+        inline const std::vector<SweepParameter>& parameters() const { return _parameters; }
+
+        inline void setRodLength(double rodLength){ _rodLength = rodLength; }
+
+        // throws std::invalid_argument for integrators Sim::solve does not support
+        void setIntegrator(Sim::IntegrationStrats integrator);
+
+        // tolerances of the adaptive integrators, as in Sim::setTolerances
+        inline void setTolerances(const Sim::StateArray& rtol, const Sim::StateArray& atol){ _tolerances = {rtol, atol}; }
+
+        // shared by every point, read only so it is safe across the pool
+        inline void setAtmosTable(std::shared_ptr<const RealAtmos::AtmosTable> table){ _atmosTable = table; }
+
+        // kpis tracked in each flight, those read by the requested metrics are tracked regardless
+        inline void setKpis(Sim::Kpis::KpiMask kpis){ _kpis = kpis; }
+
+        // checked on the base design as in create
+        void setDesignBuilder(DesignBuilder builder);
+
+        /**
+         * @brief Flies each point across a work stealing pool
+         *
+         * @param points one value per parameter for each point
+         * @param metrics the metrics to keep
+         * @param threads number of worker threads, 0 uses every core
+         * @return SweepResults in the order of points
+         */
+        SweepResults run(const std::vector<Point>& points, const std::vector<SweepMetric>& metrics, size_t threads = 0) const;
+
+        // flies the grid of the parameters values
+        SweepResults run(const std::vector<SweepMetric>& metrics, size_t threads = 0) const;
+};
+
+}
@@ -1,11 +1,24 @@
 #include "RealAtmos.hpp"
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <map>
 #include <limits>
 #include <string>
 #include <Eigen/Dense>
 
+#ifdef _WIN32
+#include <process.h>
+#include <random>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include <iostream>
 
 namespace RealAtmos
@@ -76,6 +89,14 @@ namespace RealAtmos
     // Sutherland's constant in K.
     const double S = 110.4;
 
+    // Constants defined by equation 27 from US Standard Atmosphere 1976, in K and km.
+    const double T_C = 263.1905;
+    const double A_27 = -76.3232;
+    const double a_27 = 19.9429;
+
+    // Constant defined by equation 29 from US Standard Atmosphere 1976, in km^-1.
+    const double LAMBDA = 0.01875;
+
     struct Species
     {
         double M;
@@ -106,32 +127,89 @@ namespace RealAtmos
         return y0 + (y1 - y0) * (x - x0)/(x1 - x0);
     }
 
-    double interp(double val, std::map<double, double> map) 
+    // finds the pair of entries bracketing val, values off either end of the map use the first or last interval
+    template<typename T>
+    std::pair<typename std::map<double, T>::const_iterator, typename std::map<double, T>::const_iterator> bracket(double val, const std::map<double, T>& map)
     {
         auto upper = map.upper_bound(val);
-        auto lower = upper--;
+        if (upper == map.begin()) {
+            ++upper;
+        } else if (upper == map.end()) {
+            --upper;
+        }
+        auto lower = upper;
+        --lower;
+        return {lower, upper};
+    }
+
+    double interp(double val, const std::map<double, double>& map) 
+    {
+        auto [lower, upper] = bracket(val, map);
         return interp(val, lower->first, upper->first, lower->second, upper->second);
     }
 
-    GEOP_CONSTS interp(double val, std::map<double, GEOP_CONSTS> map) 
+    GEOP_CONSTS interp(double val, const std::map<double, GEOP_CONSTS>& map) 
     {
-        auto upper = map.upper_bound(val);
-        auto lower = upper;
-        --lower;
+        auto [lower, upper] = bracket(val, map);
         auto T_MB = interp(val, lower->first, upper->first, lower->second.T_MB, upper->second.T_MB);
         auto L_MB = interp(val, lower->first, upper->first, lower->second.L_MB, upper->second.L_MB);
         auto P_B = interp(val, lower->first, upper->first, lower->second.P_B, upper->second.P_B);
         return {T_MB, L_MB, P_B};
     }
     
-    MOLE interp(double val, std::map<double, MOLE> map) 
+    // The array form of interp. The interpolant is written as its first interval's line plus a ramp at each interior key for the change in slope,
+    // which extrapolates off either end the same way without finding each element's interval.
+    template<typename T, typename F>
+    Eigen::ArrayXd interp(const Eigen::ArrayXd& val, const std::map<double, T>& map, F value)
     {
-        auto upper = map.upper_bound(val);
-        auto lower = upper;
-        --lower;
-        auto n = interp(val, lower->first, upper->first, lower->second.n, upper->second.n);
-        auto M = interp(val, lower->first, upper->first, lower->second.M, upper->second.M);
-        return {n, M};
+        auto lower = map.cbegin();
+        auto upper = std::next(lower);
+        double slope = (value(upper->second) - value(lower->second))/(upper->first - lower->first);
+        Eigen::ArrayXd result = value(lower->second) + slope * (val - lower->first);
+        // ramps starting above every value add nothing
+        const double highest = val.maxCoeff();
+        for (lower = upper++; upper != map.cend() && lower->first < highest; lower = upper++) {
+            double nextSlope = (value(upper->second) - value(lower->second))/(upper->first - lower->first);
+            result += (nextSlope - slope) * (val - lower->first).max(0.0);
+            slope = nextSlope;
+        }
+        return result;
+    }
+
+    // GEOPS as arrays indexed by layer, for gathering each element's layer constants
+    struct GEOP_ARRAYS
+    {
+        Eigen::ArrayXd H_B;
+        Eigen::ArrayXd T_MB;
+        Eigen::ArrayXd L_MB;
+        Eigen::ArrayXd P_B;
+        Eigen::ArrayXd exponent; // of the pressure equation for layers with a gradient, 0 for isothermal layers
+        Eigen::ArrayXd isothermal; // 1 for isothermal layers, 0 otherwise
+    };
+
+    const GEOP_ARRAYS& geopArrays()
+    {
+        static const GEOP_ARRAYS arrays = []() {
+            GEOP_ARRAYS res;
+            int n = GEOPS.size();
+            res.H_B.resize(n);
+            res.T_MB.resize(n);
+            res.L_MB.resize(n);
+            res.P_B.resize(n);
+            res.exponent.resize(n);
+            res.isothermal.resize(n);
+            int i = 0;
+            for (auto layer = GEOPS.cbegin(); layer != GEOPS.cend(); layer++, i++) {
+                res.H_B(i) = layer->first;
+                res.T_MB(i) = layer->second.T_MB;
+                res.L_MB(i) = layer->second.L_MB;
+                res.P_B(i) = layer->second.P_B;
+                res.exponent(i) = layer->second.L_MB == 0 ? 0 : (G_0 * M_0)/(R_STAR * layer->second.L_MB/1000);
+                res.isothermal(i) = layer->second.L_MB == 0 ? 1 : 0;
+            }
+            return res;
+        }();
+        return arrays;
     }
     
     Eigen::ArrayXd cumulative_trapezoid(Eigen::ArrayXd x, Eigen::ArrayXd y)
@@ -145,8 +223,46 @@ namespace RealAtmos
         return result;
     }
 
+    // Grid the upper atmosphere is integrated on, geometric height in meters.
+    const double UPPER_START = 86e3;
+    const double UPPER_END = 1000e3;
+    const double UPPER_STEP = 100;
+    const int UPPER_N = (UPPER_END - UPPER_START)/UPPER_STEP + 1;
+
+    // The upper atmosphere cache is this header followed by the number densities then the molar masses.
+    // The version must be bumped whenever the integration or anything it depends on changes.
+    const char CACHE_MAGIC[8] = {'F', 'S', 'A', 'T', 'M', 'O', 'S', '\0'};
+    const uint32_t CACHE_VERSION = 2;
+
+    struct CACHE_HEADER
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t count;
+        double start;
+        double step;
+        // FNV-1a over the values that follow, a truncated or altered file is recomputed rather than used
+        uint64_t checksum;
+    };
+
+    static uint64_t cacheChecksum_(const double* n, const double* M)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        auto add = [&hash](const double* values) {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values);
+            for (size_t i = 0; i < UPPER_N*sizeof(double); i++) {
+                hash = (hash ^ bytes[i])*1099511628211ull;
+            }
+        };
+        add(n);
+        add(M);
+        return hash;
+    }
+
     RealAtmos* RealAtmos::pinstance_{nullptr};
     std::mutex RealAtmos::mutex_;
+    std::filesystem::path RealAtmos::cachePath_;
+    bool RealAtmos::cachePathSet_ = false;
 
     RealAtmos *RealAtmos::GetInstance()
     {
@@ -158,14 +274,180 @@ namespace RealAtmos
         return pinstance_;
     }
 
+    void RealAtmos::setCachePath(std::filesystem::path path)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cachePath_ = path;
+        cachePathSet_ = true;
+    }
+
+    // the default is resolved the first time it is asked for rather than during static initialization,
+    // a temp directory that cannot be found just means there is no disk cache
+    std::filesystem::path RealAtmos::cachePath()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!cachePathSet_) {
+            cachePathSet_ = true;
+            std::error_code ec;
+            auto directory = std::filesystem::temp_directory_path(ec);
+            if (!ec) {
+                // the temp directory is shared, so each user keeps a cache of their own
+                std::string name = "farseer_atmos_v" + std::to_string(CACHE_VERSION);
+#ifndef _WIN32
+                name += "_" + std::to_string(getuid());
+#endif
+                cachePath_ = directory / (name + ".bin");
+            }
+        }
+        return cachePath_;
+    }
+
+    // nothing is computed up front, the lower atmosphere is analytic and the upper table is built the first time it is needed
     RealAtmos::RealAtmos()
     {
-        double start = 86e3;
-        double end = 1000e3;
-        double stepSize = 100;
-        int N = (end - start)/stepSize + 1;
+    }
 
-        Eigen::ArrayXd altitudes = Eigen::ArrayXd::LinSpaced(N, start, end);
+    void RealAtmos::upperTable_()
+    {
+        std::call_once(upperOnce, [this]() {
+            if (!loadCache_()) {
+                integrateUpper_();
+                saveCache_();
+            }
+        });
+    }
+
+    /**
+     * Maps the cached upper atmosphere table, falling back to reading it on platforms without mmap.
+     *
+     * @return Whether a cache matching this version, grid and checksum was found.
+     */
+    bool RealAtmos::loadCache_()
+    {
+        auto path = cachePath();
+        if (path.empty()) {
+            return false;
+        }
+        const size_t size = sizeof(CACHE_HEADER) + 2*UPPER_N*sizeof(double);
+        auto valid = [](const CACHE_HEADER& header) {
+            return std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 && header.version == CACHE_VERSION
+                && header.count == UPPER_N && header.start == UPPER_START && header.step == UPPER_STEP;
+        };
+#ifdef _WIN32
+        std::ifstream file(path, std::ios::binary);
+        CACHE_HEADER header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || !valid(header)) {
+            return false;
+        }
+        nGrid.resize(UPPER_N);
+        MGrid.resize(UPPER_N);
+        if (!file.read(reinterpret_cast<char*>(nGrid.data()), UPPER_N*sizeof(double)) || !file.read(reinterpret_cast<char*>(MGrid.data()), UPPER_N*sizeof(double))
+            || cacheChecksum_(nGrid.data(), MGrid.data()) != header.checksum) {
+            return false;
+        }
+        nValues = nGrid.data();
+        MValues = MGrid.data();
+        return true;
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        // only a cache this user wrote is trusted, anyone can leave a file in the temp directory
+        struct stat info;
+        void* data = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && info.st_uid == getuid() && (size_t)info.st_size == size) {
+            data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if (data == MAP_FAILED) {
+            return false;
+        }
+        const CACHE_HEADER* header = static_cast<const CACHE_HEADER*>(data);
+        const double* values = reinterpret_cast<const double*>(static_cast<const char*>(data) + sizeof(CACHE_HEADER));
+        if (!valid(*header) || cacheChecksum_(values, values + UPPER_N) != header->checksum) {
+            munmap(data, size);
+            return false;
+        }
+        mapping = data;
+        mappingSize = size;
+        nValues = values;
+        MValues = nValues + UPPER_N;
+        return true;
+#endif
+    }
+
+    // writes the table to a temporary file that is moved into place, so a partly written cache is never read.
+    // failing to write it is not an error, it is just computed again next time
+    void RealAtmos::saveCache_()
+    {
+        auto path = cachePath();
+        if (path.empty()) {
+            return;
+        }
+        CACHE_HEADER header;
+        std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header.version = CACHE_VERSION;
+        header.count = UPPER_N;
+        header.start = UPPER_START;
+        header.step = UPPER_STEP;
+        header.checksum = cacheChecksum_(nGrid.data(), MGrid.data());
+
+        // the cache path is shared by every process, so each writer needs a temporary file of its own
+        std::error_code ec;
+#ifdef _WIN32
+        auto temp = path;
+        temp += ".tmp" + std::to_string(_getpid()) + "_" + std::to_string(std::random_device{}());
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(nGrid.data()), UPPER_N*sizeof(double));
+            file.write(reinterpret_cast<const char*>(MGrid.data()), UPPER_N*sizeof(double));
+            if (!file) {
+                file.close();
+                std::filesystem::remove(temp, ec);
+                return;
+            }
+        }
+#else
+        std::string name = path.string() + ".XXXXXX";
+        int fd = mkstemp(name.data());
+        if (fd < 0) {
+            return;
+        }
+        std::filesystem::path temp = name;
+        auto writeAll = [fd](const void* data, size_t size) {
+            const char* bytes = static_cast<const char*>(data);
+            while (size > 0) {
+                ssize_t written = write(fd, bytes, size);
+                if (written < 0) {
+                    return false;
+                }
+                bytes += written;
+                size -= written;
+            }
+            return true;
+        };
+        bool ok = writeAll(&header, sizeof(header)) && writeAll(nGrid.data(), UPPER_N*sizeof(double))
+            && writeAll(MGrid.data(), UPPER_N*sizeof(double));
+        // mkstemp creates the file readable by the owner only, the cache is opened read only by anyone
+        ok = fchmod(fd, 0644) == 0 && ok;
+        ok = close(fd) == 0 && ok;
+        if (!ok) {
+            std::filesystem::remove(temp, ec);
+            return;
+        }
+#endif
+        std::filesystem::rename(temp, path, ec);
+        if (ec) {
+            std::filesystem::remove(temp, ec);
+        }
+    }
+
+    // integrates the species number densities above 86km, US Standard Atmosphere 1976 section 1.3
+    void RealAtmos::integrateUpper_()
+    {
+        Eigen::ArrayXd altitudes = Eigen::ArrayXd::LinSpaced(UPPER_N, UPPER_START, UPPER_END);
 
         Eigen::ArrayXd gravity = altitudes.unaryExpr([this](double z) { return g(z); });
         Eigen::ArrayXd T = altitudes.unaryExpr([this](double z) { return temperature(z); });
@@ -264,18 +546,19 @@ namespace RealAtmos
             M_tot(i) = M_z(altitudes(i), M_tot(i));
         }
 
-        for (auto i = 0; i < altitudes.size(); i++) {
-            double alt = altitudes(i);
-            double n = n_tot(i);
-            double M = M_tot(i);
-            MOLE mole = {n, M};
-            nMap.emplace(std::make_pair(alt, mole));
-        }
-    } 
+        nGrid = n_tot;
+        MGrid = M_tot;
+        nValues = nGrid.data();
+        MValues = MGrid.data();
+    }
 
     RealAtmos::~RealAtmos()
     {
-
+#ifndef _WIN32
+        if (mapping != nullptr) {
+            munmap(mapping, mappingSize);
+        }
+#endif
     }
 
 
@@ -295,14 +578,9 @@ namespace RealAtmos
 
             return T_M * M_ratio;
         } else if (z <= 110e3) {
-            // Constants defined by equation 27 from US Standard Atmosphere 1976
-            double Tc = 263.1905;
-            double A = -76.3232;
-            double a = 19.9429;
-
             z /= 1000;
 
-            return Tc + A* std::sqrt(1 - std::pow((z-91)/a, 2)); // Equation 27 from US Standard Atmosphere 1976
+            return T_C + A_27* std::sqrt(1 - std::pow((z-91)/a_27, 2)); // Equation 27 from US Standard Atmosphere 1976
         } else if (z <= 120e3) {
             // Convert z from meters to kilometers
             z /= 1000;
@@ -313,11 +591,9 @@ namespace RealAtmos
             z /= 1000;
             double r_0 = R_0 / 1000;
 
-            // Constants defined by equation 29 from US Standard Atmosphere 1976.
-            double lam = 0.01875;
             double xi = (z-120) * (r_0+120) / (r_0+z);
 
-            return 1000 - (1000-360) * std::exp(-lam*xi);
+            return 1000 - (1000-360) * std::exp(-LAMBDA*xi);
         }
         return 1000; 
     }
@@ -351,6 +627,200 @@ namespace RealAtmos
         return pressure(z) * M_(z)/(R_STAR * temperature(z));
     }
 
+    AtmosProperties RealAtmos::properties(double z)
+    {
+        auto H = H_(z);
+        // the layer above H gives the pressure constants
+        auto layer = GEOPS.upper_bound(H);
+        // every property is on its lower branch in this range, anywhere else they're found separately
+        if (z < -5e3 || z >= 86e3 || layer == GEOPS.end()) {
+            return {temperature(z), pressure(z), density(z), g(z), sound(z), dynamic_viscosity(z), kinematic_viscosity(z)};
+        }
+
+        AtmosProperties res;
+        // the temperature interpolation uses the end intervals off either end
+        auto upper = layer == GEOPS.begin() ? std::next(layer) : layer == GEOPS.end() ? std::prev(layer) : layer;
+        auto lower = std::prev(upper);
+        auto T_M = interp(H, lower->first, upper->first, lower->second.T_MB, upper->second.T_MB);
+
+        if (z <= 0) {
+            auto geop = GEOPS.at(0.0);
+            res.temperature = geop.T_MB - geop.L_MB*(H / 1000.0);
+        } else {
+            res.temperature = T_M * interp(z, M_M0);
+        }
+
+        auto H_lim = layer->first;
+        auto geop = layer->second;
+        if (geop.L_MB == 0) {
+            res.pressure = geop.P_B * std::exp((-G_0 * M_0 * (H-H_lim))/(R_STAR * geop.T_MB));
+        } else {
+            res.pressure = geop.P_B * std::pow(geop.T_MB / (geop.T_MB + geop.L_MB * (H-H_lim)/1000), (G_0 * M_0)/(R_STAR * geop.L_MB/1000));
+        }
+
+        res.density = res.pressure * M_0/(R_STAR * res.temperature);
+        res.g = g(z);
+        res.sound = std::sqrt(GAMMA * R_STAR * T_M/M_0);
+        res.dynamic_viscosity = BETA * std::pow(res.temperature, 1.5)/(res.temperature + S);
+        res.kinematic_viscosity = res.dynamic_viscosity/res.density;
+        return res;
+    }
+
+    Eigen::ArrayXd RealAtmos::temperature(const Eigen::ArrayXd& z)
+    {
+        Eigen::ArrayXd zc = z.max(-5e3).min(1000e3);
+
+        Eigen::ArrayXd below = GEOPS.at(0.0).T_MB - GEOPS.at(0.0).L_MB * H_(zc) / 1000.0;
+        Eigen::ArrayXd lowerZ = zc.max(0.0).min(86e3);
+        Eigen::ArrayXd result = (zc <= 0).select(below, Tm_(lowerZ) * interp(lowerZ, M_M0, [](double ratio) { return ratio; }));
+        if ((zc <= 91e3).all()) {
+            return result;
+        }
+
+        // every branch above 91km is evaluated in km with its input clamped to where it is defined
+        Eigen::ArrayXd km = zc / 1000;
+        Eigen::ArrayXd ellipse = T_C + A_27 * (1 - ((km.max(91.0).min(110.0) - 91)/a_27).square()).sqrt();
+        Eigen::ArrayXd linear = 240 + 12 * (km - 110);
+        double r_0 = R_0 / 1000;
+        Eigen::ArrayXd xi = (km.max(120.0) - 120) * (r_0+120) / (r_0 + km.max(120.0));
+        Eigen::ArrayXd exosphere = 1000 - (1000-360) * (-LAMBDA*xi).exp();
+        return (zc <= 91e3).select(result, (zc <= 110e3).select(ellipse, (zc <= 120e3).select(linear, exosphere)));
+    }
+
+    Eigen::ArrayXd RealAtmos::pressure(const Eigen::ArrayXd& z)
+    {
+        const GEOP_ARRAYS& layers = geopArrays();
+        Eigen::ArrayXd zc = z.max(-5e3).min(1000e3);
+
+        // the scalar form takes its constants from the first layer based above H, the last layer is used past the top.
+        // only finding the layer is done element by element, the rest is evaluated across the array
+        Eigen::ArrayXd H = H_(zc.min(86e3));
+        const int top = layers.H_B.size() - 1;
+        Eigen::ArrayXd H_lim(H.size()), T_MB(H.size()), L_MB(H.size()), P_B(H.size()), exponent(H.size()), isothermal(H.size());
+        for (int i = 0; i < H.size(); i++) {
+            int layer = 0;
+            while (layer < top && H(i) >= layers.H_B(layer)) {
+                layer++;
+            }
+            H_lim(i) = layers.H_B(layer);
+            T_MB(i) = layers.T_MB(layer);
+            L_MB(i) = layers.L_MB(layer);
+            P_B(i) = layers.P_B(layer);
+            exponent(i) = layers.exponent(layer);
+            isothermal(i) = layers.isothermal(layer);
+        }
+        // the isothermal and gradient forms are both written as exponentials and weighted so neither has to be selected,
+        // the gradient term is zero in isothermal layers as its exponent is
+        Eigen::ArrayXd dH = H - H_lim;
+        Eigen::ArrayXd result = P_B * (isothermal * (-G_0 * M_0 * dH)/(R_STAR * T_MB) + exponent * (T_MB / (T_MB + L_MB * dH/1000)).log()).exp();
+
+        if ((zc < 86e3).all()) {
+            return result;
+        }
+        result = (zc < 86e3).select(result, n_(zc) * R_STAR * temperature(zc) / N_A);
+        return (z > 1000e3).select(0.0, result);
+    }
+
+    Eigen::ArrayXd RealAtmos::density(const Eigen::ArrayXd& z)
+    {
+        return pressure(z) * M_(z)/(R_STAR * temperature(z));
+    }
+
+    Eigen::ArrayXd RealAtmos::g(const Eigen::ArrayXd& z)
+    {
+        return G_0 * (R_0/(R_0 + z)).square();
+    }
+
+    Eigen::ArrayXd RealAtmos::sound(const Eigen::ArrayXd& z)
+    {
+        return (GAMMA * R_STAR * Tm_(z.max(-5e3).min(86e3))/M_0).sqrt();
+    }
+
+    Eigen::ArrayXd RealAtmos::dynamic_viscosity(const Eigen::ArrayXd& z)
+    {
+        Eigen::ArrayXd T = temperature(z.max(-5e3).min(86e3));
+        return BETA * T * T.sqrt()/(T + S);
+    }
+
+    Eigen::ArrayXd RealAtmos::kinematic_viscosity(const Eigen::ArrayXd& z)
+    {
+        return dynamic_viscosity(z)/density(z);
+    }
+
+    template<int N>
+    void RealAtmos::properties(const Eigen::Array<double, N, 1>& z, AtmosPropertiesArray<N>& out)
+    {
+        using Values = typename AtmosPropertiesArray<N>::Values;
+        const GEOP_ARRAYS& layers = geopArrays();
+        const int top = layers.H_B.size() - 1;
+
+        // as the scalar form, the layer above H gives the pressure constants and the layers either side of H the molecular-scale temperature.
+        // finding them and the molecular-weight ratio is done element by element, the rest across the array
+        const Values zc = z.max(-5e3).min(86e3);
+        const Values H = (R_0 * zc)/(R_0 + zc);
+        Values H_lim, T_MB, L_MB, P_B, exponent, isothermal, T_M, ratio;
+        for (int i = 0; i < N; i++) {
+            int layer = 0;
+            while (layer < top && H(i) >= layers.H_B(layer)) {
+                layer++;
+            }
+            H_lim(i) = layers.H_B(layer);
+            T_MB(i) = layers.T_MB(layer);
+            L_MB(i) = layers.L_MB(layer);
+            P_B(i) = layers.P_B(layer);
+            exponent(i) = layers.exponent(layer);
+            isothermal(i) = layers.isothermal(layer);
+            const int upper = std::max(layer, 1);
+            T_M(i) = interp(H(i), layers.H_B(upper - 1), layers.H_B(upper), layers.T_MB(upper - 1), layers.T_MB(upper));
+            ratio(i) = zc(i) <= 0 ? 1.0 : interp(zc(i), M_M0);
+        }
+
+        const Values dH = H - H_lim;
+        out.temperature = (zc <= 0).select(GEOPS.at(0.0).T_MB - GEOPS.at(0.0).L_MB * H / 1000.0, T_M * ratio);
+        out.pressure = P_B * (isothermal * (-G_0 * M_0 * dH)/(R_STAR * T_MB) + exponent * (T_MB / (T_MB + L_MB * dH/1000)).log()).exp();
+        out.density = out.pressure * M_0/(R_STAR * out.temperature);
+        out.g = G_0 * (R_0/(R_0 + z)).square();
+        out.sound = (GAMMA * R_STAR * T_M/M_0).sqrt();
+        out.dynamic_viscosity = BETA * out.temperature * out.temperature.sqrt()/(out.temperature + S);
+        out.kinematic_viscosity = out.dynamic_viscosity/out.density;
+
+        // altitudes off the lower atmosphere take the scalar path, which finds every property separately there
+        for (int i = 0; i < N; i++) {
+            if (z(i) < -5e3 || z(i) >= 86e3 || H(i) >= layers.H_B(top)) {
+                const AtmosProperties res = properties(z(i));
+                out.temperature(i) = res.temperature;
+                out.pressure(i) = res.pressure;
+                out.density(i) = res.density;
+                out.g(i) = res.g;
+                out.sound(i) = res.sound;
+                out.dynamic_viscosity(i) = res.dynamic_viscosity;
+                out.kinematic_viscosity(i) = res.kinematic_viscosity;
+            }
+        }
+    }
+
+    template void RealAtmos::properties<4>(const Eigen::Array<double, 4, 1>& z, AtmosPropertiesArray<4>& out);
+    template void RealAtmos::properties<8>(const Eigen::Array<double, 8, 1>& z, AtmosPropertiesArray<8>& out);
+
+    std::vector<double> RealAtmos::breakpoints()
+    {
+        std::vector<double> points;
+        // converting the geopotential layer bases back to geometric heights
+        for (auto layer = GEOPS.cbegin(); layer != GEOPS.cend(); layer++) {
+            points.push_back(R_0 * layer->first/(R_0 - layer->first));
+        }
+        // the molecular-weight ratio is interpolated linearly between its entries so its slope changes at each
+        for (auto entry = M_M0.cbegin(); entry != M_M0.cend(); entry++) {
+            points.push_back(entry->first);
+        }
+        for (double z : {86e3, 91e3, 110e3, 120e3, 1000e3}) {
+            points.push_back(z);
+        }
+        std::sort(points.begin(), points.end());
+        points.erase(std::unique(points.begin(), points.end()), points.end());
+        return points;
+    }
+
     double RealAtmos::g(double z)
     {
         return G_0 * std::pow( R_0/(R_0 + z),2);
@@ -404,8 +874,8 @@ namespace RealAtmos
      */
     double RealAtmos::n_(double z)
     {
-        auto mole = interp(z, nMap);
-        return mole.n;
+        upperTable_();
+        return gridInterp_(z, nValues);
     }
 
     /**
@@ -417,8 +887,57 @@ namespace RealAtmos
     double RealAtmos::M_(double z)
     {
         if(z <= 86e3) return M_0;
-        auto mole = interp(z, nMap);
-        return mole.M;
+        upperTable_();
+        return gridInterp_(z, MValues);
+    }
+
+    Eigen::ArrayXd RealAtmos::H_(const Eigen::ArrayXd& z)
+    {
+        return (R_0 * z)/(R_0 + z);
+    }
+
+    Eigen::ArrayXd RealAtmos::Tm_(const Eigen::ArrayXd& z)
+    {
+        return interp(H_(z), GEOPS, [](const GEOP_CONSTS& geop) { return geop.T_MB; });
+    }
+
+    Eigen::ArrayXd RealAtmos::n_(const Eigen::ArrayXd& z)
+    {
+        upperTable_();
+        return gridInterp_(z, nValues);
+    }
+
+    Eigen::ArrayXd RealAtmos::M_(const Eigen::ArrayXd& z)
+    {
+        if ((z <= 86e3).all()) {
+            return Eigen::ArrayXd::Constant(z.size(), M_0);
+        }
+        upperTable_();
+        return (z <= 86e3).select(M_0, gridInterp_(z, MValues));
+    }
+
+    /**
+     * Linearly interpolates values on the upper atmosphere grid. Altitudes off either end use the first or last interval.
+     *
+     * @param z the geometric height in meters
+     * @param values the values at each grid altitude
+     * @return The interpolated value.
+     */
+    double RealAtmos::gridInterp_(double z, const double* values)
+    {
+        double position = (z - UPPER_START)/UPPER_STEP;
+        int lower = std::clamp(std::floor(position), 0.0, UPPER_N - 2.0);
+        return values[lower] + (values[lower + 1] - values[lower]) * (position - lower);
+    }
+
+    Eigen::ArrayXd RealAtmos::gridInterp_(const Eigen::ArrayXd& z, const double* values)
+    {
+        Eigen::Map<const Eigen::ArrayXd> grid(values, UPPER_N);
+        Eigen::ArrayXd position = (z - UPPER_START)/UPPER_STEP;
+        Eigen::ArrayXi lower = position.floor().max(0.0).min(UPPER_N - 2.0).cast<int>();
+        Eigen::ArrayXi upper = lower + 1;
+        Eigen::ArrayXd lowerValues = grid(lower);
+        return lowerValues + (grid(upper) - lowerValues) * (position - lower.cast<double>());
     }
 
     double RealAtmos::K_(double z)
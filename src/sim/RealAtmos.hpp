@@ -1,16 +1,40 @@
 #pragma once
 
+#include <filesystem>
 #include <mutex>
 #include <map>
+#include <vector>
+#include <Eigen/Dense>
 
 namespace RealAtmos
 {
     const extern double R_0;
     
-    struct MOLE
+    // every property at one altitude
+    struct AtmosProperties
     {
-        double n;
-        double M;
+        double temperature;
+        double pressure;
+        double density;
+        double g;
+        double sound;
+        double dynamic_viscosity;
+        double kinematic_viscosity;
+    };
+
+    // every property at a fixed number of altitudes, each element matching AtmosProperties at that altitude
+    template<int N>
+    struct AtmosPropertiesArray
+    {
+        using Values = Eigen::Array<double, N, 1>;
+
+        Values temperature;
+        Values pressure;
+        Values density;
+        Values g;
+        Values sound;
+        Values dynamic_viscosity;
+        Values kinematic_viscosity;
     };
 
     class RealAtmos
@@ -18,18 +42,40 @@ namespace RealAtmos
         private:
             static RealAtmos * pinstance_;
             static std::mutex mutex_;
+            static std::filesystem::path cachePath_;
+            static bool cachePathSet_;
 
         
         protected:
             RealAtmos();
             ~RealAtmos();
             
-            std::map<double, MOLE> nMap;
+            // number density and molar mass above 86km on a uniform grid, only built when first needed
+            std::once_flag upperOnce;
+            const double* nValues = nullptr;
+            const double* MValues = nullptr;
+            // backing for the values when they are computed or read rather than mapped
+            Eigen::ArrayXd nGrid;
+            Eigen::ArrayXd MGrid;
+            void* mapping = nullptr;
+            size_t mappingSize = 0;
+
+            void upperTable_();
+            void integrateUpper_();
+            bool loadCache_();
+            void saveCache_();
 
             double H_(double z);
             double Tm_(double z);
             double n_(double z);
             double M_(double z);
+
+            Eigen::ArrayXd H_(const Eigen::ArrayXd& z);
+            Eigen::ArrayXd Tm_(const Eigen::ArrayXd& z);
+            Eigen::ArrayXd n_(const Eigen::ArrayXd& z);
+            Eigen::ArrayXd M_(const Eigen::ArrayXd& z);
+            double gridInterp_(double z, const double* values);
+            Eigen::ArrayXd gridInterp_(const Eigen::ArrayXd& z, const double* values);
             
             double K_(double z);
             double dTdZ_(double z);
@@ -42,6 +88,13 @@ namespace RealAtmos
 
             static RealAtmos * GetInstance();
 
+            /**
+             * Sets where the upper atmosphere table is cached between runs, an empty path always recomputes it.
+             * Defaults to a file of the current user's in the temp directory, only takes effect if set before the table is first needed.
+             */
+            static void setCachePath(std::filesystem::path path);
+            static std::filesystem::path cachePath();
+
             // atmospheric property funcs
             double temperature(double z);
             double pressure(double z);
@@ -51,7 +104,27 @@ namespace RealAtmos
             double dynamic_viscosity(double z);
             double kinematic_viscosity(double z);
 
+            // every property at once, identical to calling each function but sharing the geopotential height and layer search between them
+            AtmosProperties properties(double z);
+
+            // array forms, each element matches the scalar form at that altitude
+            // the branches are selected per element rather than taken so they vectorize
+            Eigen::ArrayXd temperature(const Eigen::ArrayXd& z);
+            Eigen::ArrayXd pressure(const Eigen::ArrayXd& z);
+            Eigen::ArrayXd density(const Eigen::ArrayXd& z);
+            Eigen::ArrayXd g(const Eigen::ArrayXd& z);
+            Eigen::ArrayXd sound(const Eigen::ArrayXd& z);
+            Eigen::ArrayXd dynamic_viscosity(const Eigen::ArrayXd& z);
+            Eigen::ArrayXd kinematic_viscosity(const Eigen::ArrayXd& z);
+
+            // every property at once for a fixed number of altitudes, the array form of properties.
+            // nothing is allocated so it can be called every step, only instantiated for BatchSim's lane counts
+            template<int N>
+            void properties(const Eigen::Array<double, N, 1>& z, AtmosPropertiesArray<N>& out);
+
             // constant accessors
+            // geometric altitudes in meters where the model changes branch, layer or interpolated entry, properties may jump or kink across these
+            static std::vector<double> breakpoints();
 
     };
 
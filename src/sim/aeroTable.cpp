@@ -0,0 +1,290 @@
+#include "aeroTable.hpp"
+#include "threadPool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <numbers>
+#include <stdexcept>
+
+namespace Sim{
+
+    static const char FILE_MAGIC[8] = { 'F', 'S', 'A', 'E', 'R', 'O', '\0', '\0' };
+    static const uint32_t FILE_VERSION = 2;
+
+    struct FILE_HEADER{
+        char magic[8];
+        uint32_t version;
+        uint32_t coefficients;
+        uint64_t nMach;
+        uint64_t nAlpha;
+        uint64_t nReL;
+        double gamma;
+    };
+
+    // axis lengths are checked against this when loading so a corrupt file can't cause a huge allocation
+    static const uint64_t MAX_AXIS = 1 << 16;
+
+    // smaller normal force coefficients are treated as none when dividing the cp back out
+    static const double MIN_CN = 1e-9;
+
+    AeroAxes AeroAxes::defaults(){
+        AeroAxes axes;
+        for(int i = 0; i <= 60; i++){
+            axes.mach.push_back(0.05*i);
+        }
+        for(int i = 0; i <= 90; i++){
+            axes.alpha.push_back(i*std::numbers::pi/90);
+        }
+        for(int i = 0; i <= 20; i++){
+            axes.reL.push_back(std::pow(10.0, 3 + 0.25*i));
+        }
+        return axes;
+    }
+
+    // index of the interval containing x and the fraction of the way across it, nothing if x is outside the axis
+    static std::optional<std::pair<size_t, double>> locate(const std::vector<double>& axis, double x){
+        if(axis.size() < 2 || !(x >= axis.front() && x <= axis.back())){
+            return std::nullopt;
+        }
+        size_t i = std::upper_bound(axis.cbegin(), axis.cend(), x) - axis.cbegin();
+        i = std::clamp<size_t>(i, 1, axis.size() - 1) - 1;
+        return std::make_pair(i, (x - axis[i])/(axis[i + 1] - axis[i]));
+    }
+
+    static void checkAxis(const std::vector<double>& axis, const char* name){
+        if(axis.size() < 2){
+            throw std::invalid_argument(std::string("aero table ") + name + " axis needs at least 2 points");
+        }
+        for(size_t i = 1; i < axis.size(); i++){
+            if(!(axis[i] > axis[i - 1])){
+                throw std::invalid_argument(std::string("aero table ") + name + " axis must be strictly increasing");
+            }
+        }
+    }
+
+    AeroTable::AeroTable(RocketInterface* rocket, AeroAxes axes){
+        checkAxis(axes.mach, "mach");
+        checkAxis(axes.alpha, "alpha");
+        checkAxis(axes.reL, "reL");
+        if(axes.reL.front() <= 0){
+            throw std::invalid_argument("aero table reL axis must be positive");
+        }
+        _rocket = rocket;
+        _axes = axes;
+        for(auto re = _axes.reL.cbegin(); re != _axes.reL.cend(); re++){
+            _logReL.push_back(std::log10(*re));
+        }
+        _values.resize(NUM_COEFFICIENTS, _axes.mach.size()*_axes.alpha.size()*_axes.reL.size());
+    }
+
+    AeroTable::Values AeroTable::sample(RocketInterface* rocket, double mach, double alpha, double reL, double gamma){
+        const FlightState state = FlightState(0, mach, alpha, 0, 0, reL, gamma);
+        Values res;
+        res[CN] = rocket->c_n(state);
+        res[CM] = rocket->c_m(state);
+        // with no normal force the rocket reports some other point as its cp, c_n*cp goes to zero there anyway
+        res.segment<3>(CPX) = res[CN]*rocket->cp(state).array();
+        res[CDF] = rocket->Cdf(state);
+        res[CDP] = rocket->Cdp(state);
+        return res;
+    }
+
+    void AeroTable::fill(RocketInterface* rocket, size_t i){
+        for(size_t j = 0; j < _axes.alpha.size(); j++){
+            for(size_t k = 0; k < _axes.reL.size(); k++){
+                _values.col(index(i, j, k)) = sample(rocket, _axes.mach[i], _axes.alpha[j], _axes.reL[k], _gamma);
+            }
+        }
+    }
+
+    std::shared_ptr<AeroTable> AeroTable::create(RocketInterface* rocket, AeroAxes axes, RocketFactory factory, size_t threads){
+        auto obj = std::shared_ptr<AeroTable>(
+            new AeroTable(rocket, axes)
+        );
+        if(!factory){
+            for(size_t i = 0; i < obj->_axes.mach.size(); i++){
+                obj->fill(rocket, i);
+            }
+            return obj;
+        }
+        // every task writes its own columns so no locking is needed
+        ThreadPool pool(threads);
+        AeroTable* table = obj.get();
+        for(size_t i = 0; i < table->_axes.mach.size(); i++){
+            pool.submit([table, &factory, i](){
+                auto copy = factory();
+                table->fill(copy.get(), i);
+            });
+        }
+        pool.wait();
+        return obj;
+    }
+
+    void AeroTable::save(const std::filesystem::path& path) const {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if(!file){
+            throw std::runtime_error("could not open " + path.string() + " to save the aero table");
+        }
+        FILE_HEADER header;
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.version = FILE_VERSION;
+        header.coefficients = NUM_COEFFICIENTS;
+        header.nMach = _axes.mach.size();
+        header.nAlpha = _axes.alpha.size();
+        header.nReL = _axes.reL.size();
+        header.gamma = _gamma;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for(const std::vector<double>* axis : { &_axes.mach, &_axes.alpha, &_axes.reL }){
+            file.write(reinterpret_cast<const char*>(axis->data()), axis->size()*sizeof(double));
+        }
+        file.write(reinterpret_cast<const char*>(_values.data()), _values.size()*sizeof(double));
+        if(!file){
+            throw std::runtime_error("could not write the aero table to " + path.string());
+        }
+    }
+
+    std::shared_ptr<AeroTable> AeroTable::load(RocketInterface* rocket, const std::filesystem::path& path){
+        std::ifstream file(path, std::ios::binary);
+        FILE_HEADER header;
+        if(!file.read(reinterpret_cast<char*>(&header), sizeof(header))){
+            return nullptr;
+        }
+        if(std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FILE_VERSION || header.coefficients != NUM_COEFFICIENTS){
+            return nullptr;
+        }
+        if(header.nMach > MAX_AXIS || header.nAlpha > MAX_AXIS || header.nReL > MAX_AXIS){
+            return nullptr;
+        }
+        // the axes and grid must be exactly what is left of the file before anything is allocated for them
+        std::error_code ec;
+        const uint64_t size = std::filesystem::file_size(path, ec);
+        const uint64_t expected = sizeof(header)
+            + (header.nMach + header.nAlpha + header.nReL + NUM_COEFFICIENTS*header.nMach*header.nAlpha*header.nReL)*sizeof(double);
+        if(ec || size != expected){
+            return nullptr;
+        }
+        AeroAxes axes;
+        axes.mach.resize(header.nMach);
+        axes.alpha.resize(header.nAlpha);
+        axes.reL.resize(header.nReL);
+        for(std::vector<double>* axis : { &axes.mach, &axes.alpha, &axes.reL }){
+            if(!file.read(reinterpret_cast<char*>(axis->data()), axis->size()*sizeof(double))){
+                return nullptr;
+            }
+        }
+        std::shared_ptr<AeroTable> obj;
+        try{
+            obj = std::shared_ptr<AeroTable>(
+                new AeroTable(rocket, axes)
+            );
+        } catch(const std::invalid_argument&){
+            return nullptr;
+        }
+        obj->_gamma = header.gamma;
+        if(!file.read(reinterpret_cast<char*>(obj->_values.data()), obj->_values.size()*sizeof(double))){
+            return nullptr;
+        }
+        return obj;
+    }
+
+    const std::optional<AeroTable::Values>& AeroTable::lookup(const FlightState& state){
+        if(_lastState && *_lastState == state){
+            return _last;
+        }
+        _lastState = state;
+        _last = std::nullopt;
+        if(state.gamma() != _gamma || !(state.reL() > 0)){
+            return _last;
+        }
+        const auto m = locate(_axes.mach, state.mach());
+        const auto a = locate(_axes.alpha, state.alpha());
+        const auto r = locate(_logReL, std::log10(state.reL()));
+        if(!m || !a || !r){
+            return _last;
+        }
+
+        // trilinear, collapsing one axis at a time
+        const auto [i, tm] = *m;
+        const auto [j, ta] = *a;
+        const auto [k, tr] = *r;
+        auto alongReL = [this, k, tr](size_t i, size_t j) -> Values {
+            return (1 - tr)*_values.col(index(i, j, k)) + tr*_values.col(index(i, j, k + 1));
+        };
+        auto alongMach = [&alongReL, i, tm](size_t j) -> Values {
+            return (1 - tm)*alongReL(i, j) + tm*alongReL(i + 1, j);
+        };
+        const Values lower = alongMach(j);
+        const Values upper = alongMach(j + 1);
+        Values values = (1 - ta)*lower + ta*upper;
+
+        // the cp is the interpolated moment over the interpolated c_n, without a normal force it is the limit as c_n goes to
+        // zero, the ratio of their slopes across the alpha interval. A rocket with no normal force across it keeps its own cp
+        const Values slope = upper - lower;
+        if(std::abs(values[CN]) > MIN_CN){
+            values.segment<3>(CPX) /= values[CN];
+        } else if(std::abs(slope[CN]) > MIN_CN){
+            values.segment<3>(CPX) = slope.segment<3>(CPX)/slope[CN];
+        } else {
+            values.segment<3>(CPX) = _rocket->cp(state).array();
+        }
+        _last = values;
+        return _last;
+    }
+
+    std::optional<AeroTable::Values> AeroTable::coefficients(const FlightState& state){
+        return lookup(state);
+    }
+
+    RocketSnapshot AeroTable::evaluate(const FlightState& state, bool massProperties){
+        const auto& values = lookup(state);
+        if(!values){
+            return _rocket->evaluate(state, massProperties);
+        }
+        // only the quantities that are not tabulated are asked of the wrapped rocket
+        RocketSnapshot res;
+        if(massProperties){
+            res.mass = _rocket->mass(state);
+            res.cm = _rocket->cm(state);
+            res.inertia = _rocket->inertia(state);
+        }
+        res.thrust = _rocket->thrust(state);
+        res.referenceArea = _rocket->referenceArea(state);
+        res.referenceLength = _rocket->referenceLength(state);
+        res.c_m_damp_pitch = _rocket->c_m_damp_pitch(state);
+        res.c_m_damp_yaw = _rocket->c_m_damp_yaw(state);
+        res.Cdb = _rocket->Cdb(state);
+        res.c_n = (*values)[CN];
+        res.c_m = (*values)[CM];
+        res.cp = Eigen::Vector3d{ (*values)[CPX], (*values)[CPY], (*values)[CPZ] };
+        res.Cdf = (*values)[CDF];
+        res.Cdp = (*values)[CDP];
+        return res;
+    }
+
+    double AeroTable::c_n(const FlightState& state){
+        const auto& values = lookup(state);
+        return values ? (*values)[CN] : _rocket->c_n(state);
+    }
+
+    double AeroTable::c_m(const FlightState& state){
+        const auto& values = lookup(state);
+        return values ? (*values)[CM] : _rocket->c_m(state);
+    }
+
+    Eigen::Vector3d AeroTable::cp(const FlightState& state){
+        const auto& values = lookup(state);
+        return values ? Eigen::Vector3d{ (*values)[CPX], (*values)[CPY], (*values)[CPZ] } : _rocket->cp(state);
+    }
+
+    double AeroTable::Cdf(const FlightState& state){
+        const auto& values = lookup(state);
+        return values ? (*values)[CDF] : _rocket->Cdf(state);
+    }
+
+    double AeroTable::Cdp(const FlightState& state){
+        const auto& values = lookup(state);
+        return values ? (*values)[CDP] : _rocket->Cdp(state);
+    }
+}
@@ -0,0 +1,133 @@
+#ifndef AERO_TABLE_H_
+#define AERO_TABLE_H_
+
+#include "rocketInterface.hpp"
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <Eigen/Dense>
+
+namespace Sim{
+
+    /**
+     * @brief Grid points an AeroTable samples the rocket at along each axis, each must be strictly increasing
+     */
+    struct AeroAxes{
+        std::vector<double> mach;
+        std::vector<double> alpha; // radians
+        std::vector<double> reL; // reynolds number per meter, interpolated in log space so must be positive
+
+        // mach 0 to 3 every 0.05, alpha 0 to 180 degrees every 2 degrees, reL 1e3 to 1e8 every quarter decade
+        static AeroAxes defaults();
+    };
+
+    /**
+     * @brief Wraps a rocket, reading its aerodynamic coefficients from a grid over mach, alpha and reL
+     * c_n, c_m, cp, Cdf and Cdp depend only on the rockets geometry and the flow so they are evaluated once over the grid and
+     * trilinearly interpolated afterwards. The grid holds c_n*cp rather than cp, the normal force's moment is what varies smoothly
+     * and the cp is divided back out after interpolating. Everything else, including the damping coefficients which depend on the angular rates
+     * and Cdb which depends on the motor, is passed through to the wrapped rocket, as is any state outside the grid or at another gamma
+     */
+    class AeroTable : public RocketInterface{
+        public:
+            /**
+             * @brief Creates a copy of the rocket for a worker, components cache their results so a rocket cannot be shared between threads
+             */
+            using RocketFactory = std::function<std::shared_ptr<RocketInterface>()>;
+
+            // rows of the table, the cp rows are stored multiplied by c_n
+            enum Coefficient{
+                CN,
+                CM,
+                CPX,
+                CPY,
+                CPZ,
+                CDF,
+                CDP,
+                NUM_COEFFICIENTS
+            };
+
+            using Values = Eigen::Array<double, NUM_COEFFICIENTS, 1>;
+
+        private:
+            RocketInterface* _rocket;
+            AeroAxes _axes;
+            std::vector<double> _logReL;
+            double _gamma = 1.4; // the gamma the grid was sampled at
+            // one column per grid point, reL varies fastest then alpha then mach
+            Eigen::Array<double, NUM_COEFFICIENTS, Eigen::Dynamic> _values;
+
+            // the last lookup, the sim asks for each coefficient separately at the same state
+            std::optional<FlightState> _lastState;
+            std::optional<Values> _last;
+
+            AeroTable(RocketInterface* rocket, AeroAxes axes);
+
+            inline Eigen::Index index(size_t i, size_t j, size_t k) const {
+                return (i*_axes.alpha.size() + j)*_axes.reL.size() + k;
+            }
+
+            static Values sample(RocketInterface* rocket, double mach, double alpha, double reL, double gamma);
+            // fills the grid for every alpha and reL at mach index i
+            void fill(RocketInterface* rocket, size_t i);
+            // the interpolated coefficients, or nothing if the state is outside the grid
+            const std::optional<Values>& lookup(const FlightState& state);
+
+        public:
+            /**
+             * @brief Samples the rocket over the grid, one task per mach number
+             *
+             * @param rocket the rocket to wrap, it is sampled directly unless a factory is given
+             * @param axes the grid to sample
+             * @param factory when set the grid is filled in parallel with a rocket from this per task
+             * @param threads number of worker threads, 0 uses every core
+             * @return std::shared_ptr<AeroTable>
+             */
+            static std::shared_ptr<AeroTable> create(RocketInterface* rocket, AeroAxes axes = AeroAxes::defaults(), RocketFactory factory = nullptr, size_t threads = 0);
+
+            /**
+             * @brief Loads a table written by save for the same rocket, the file does not identify the rocket so keep it with the design
+             *
+             * @param rocket the rocket to wrap
+             * @param path the file to read
+             * @return std::shared_ptr<AeroTable> nullptr if the file is missing or is not a valid table
+             */
+            static std::shared_ptr<AeroTable> load(RocketInterface* rocket, const std::filesystem::path& path);
+
+            // writes the axes and grid to a file, throws std::runtime_error if it cannot be written
+            void save(const std::filesystem::path& path) const;
+
+            inline const AeroAxes& axes() const { return _axes; }
+            inline RocketInterface* rocket() const { return _rocket; }
+
+            // the interpolated coefficients at a state, or nothing if the state is outside the grid
+            std::optional<Values> coefficients(const FlightState& state);
+
+            // passed through
+            virtual Eigen::Vector3d thisWayUp() override { return _rocket->thisWayUp(); }
+            virtual Eigen::Vector3d cm(const FlightState& state) override { return _rocket->cm(state); }
+            virtual Eigen::Matrix3d inertia(const FlightState& state) override { return _rocket->inertia(state); }
+            virtual double mass(const FlightState& state) override { return _rocket->mass(state); }
+            virtual Eigen::Vector3d thrust(const FlightState& state) override { return _rocket->thrust(state); }
+            virtual Eigen::Vector3d thrustPosition(const FlightState& state) override { return _rocket->thrustPosition(state); }
+            virtual double referenceArea(const FlightState& state) override { return _rocket->referenceArea(state); }
+            virtual double referenceLength(const FlightState& state) override { return _rocket->referenceLength(state); }
+            virtual double c_m_damp_pitch(const FlightState& state) override { return _rocket->c_m_damp_pitch(state); }
+            virtual double c_m_damp_yaw(const FlightState& state) override { return _rocket->c_m_damp_yaw(state); }
+            virtual double Cdb(const FlightState& state) override { return _rocket->Cdb(state); }
+
+            // the tabulated coefficients with everything else from the wrapped rocket, which supplies it all outside the table
+            virtual RocketSnapshot evaluate(const FlightState& state, bool massProperties) override;
+
+            // tabulated
+            virtual double c_n(const FlightState& state) override;
+            virtual double c_m(const FlightState& state) override;
+            virtual Eigen::Vector3d cp(const FlightState& state) override;
+            virtual double Cdf(const FlightState& state) override;
+            virtual double Cdp(const FlightState& state) override;
+    };
+}
+
+#endif
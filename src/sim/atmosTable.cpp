@@ -0,0 +1,223 @@
+#include "atmosTable.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace RealAtmos
+{
+
+    // how far inside its segment a node on a breakpoint is sampled, so it takes the limit of the model from its own layer
+    const double EDGE_NUDGE = 1e-6;
+
+    AtmosTable::AtmosTable(RealAtmos* atmos, double zMin, double zMax, double spacing, TableInterpolation method)
+    {
+        _atmos = atmos;
+        _spacing = spacing;
+        _method = method;
+        _zMin = zMin;
+        _zMax = zMax;
+
+        std::vector<double> edges = {zMin};
+        for (double z : RealAtmos::breakpoints()) {
+            if (z > zMin && z < zMax) {
+                edges.push_back(z);
+            }
+        }
+        edges.push_back(zMax);
+
+        Eigen::Index total = 0;
+        for (size_t k = 0; k + 1 < edges.size(); k++) {
+            double width = edges[k + 1] - edges[k];
+            // at least two intervals per segment so the cubic end intervals can extrapolate a quadratic ghost point
+            Eigen::Index intervals = std::max<Eigen::Index>(2, (Eigen::Index)std::ceil(width/spacing));
+            double segSpacing = width/intervals;
+            _segments.push_back({edges[k], segSpacing, 1.0/segSpacing, total, intervals + 1});
+            total += intervals + 1;
+        }
+
+        Eigen::ArrayXd altitudes(total);
+        for (const Segment& seg : _segments) {
+            altitudes.segment(seg.first, seg.n) = Eigen::ArrayXd::LinSpaced(seg.n, seg.zLower, seg.zLower + (seg.n - 1)*seg.spacing);
+            altitudes(seg.first) += EDGE_NUDGE;
+            altitudes(seg.first + seg.n - 1) -= EDGE_NUDGE;
+        }
+
+        _temperature = altitudes.unaryExpr([atmos](double z) { return atmos->temperature(z); });
+        _pressure = altitudes.unaryExpr([atmos](double z) { return atmos->pressure(z); });
+        _density = altitudes.unaryExpr([atmos](double z) { return atmos->density(z); });
+        _g = altitudes.unaryExpr([atmos](double z) { return atmos->g(z); });
+        _sound = altitudes.unaryExpr([atmos](double z) { return atmos->sound(z); });
+        _dynamicViscosity = altitudes.unaryExpr([atmos](double z) { return atmos->dynamic_viscosity(z); });
+        _kinematicViscosity = altitudes.unaryExpr([atmos](double z) { return atmos->kinematic_viscosity(z); });
+
+        _maxError = measureError();
+    }
+
+    std::shared_ptr<AtmosTable> AtmosTable::create(RealAtmos* atmos, double tolerance, double zMin, double zMax, TableInterpolation method, double initialSpacing, double minSpacing)
+    {
+        double spacing = initialSpacing;
+        auto table = std::make_shared<AtmosTable>(atmos, zMin, zMax, spacing, method);
+        while (table->maxError() > tolerance && spacing/2 >= minSpacing) {
+            spacing /= 2;
+            table = std::make_shared<AtmosTable>(atmos, zMin, zMax, spacing, method);
+        }
+        return table;
+    }
+
+    const AtmosTable::Segment& AtmosTable::locate(double z, Eigen::Index& i, double& t) const
+    {
+        // there are only a handful of layers so a linear search from the top is as quick as bisecting
+        auto seg = _segments.cend() - 1;
+        while (seg != _segments.cbegin() && z < seg->zLower) {
+            seg--;
+        }
+        double u = (z - seg->zLower)*seg->invSpacing;
+        i = std::clamp((Eigen::Index)u, (Eigen::Index)0, seg->n - 2);
+        t = u - i;
+        return *seg;
+    }
+
+    double AtmosTable::lookup(const Eigen::ArrayXd& table, double z) const
+    {
+        Eigen::Index i;
+        double t;
+        const Segment& seg = locate(z, i, t);
+        return interpolate(table, seg, i, t);
+    }
+
+    double AtmosTable::interpolate(const Eigen::ArrayXd& table, const Segment& seg, Eigen::Index i, double t) const
+    {
+        Eigen::Index j = seg.first + i;
+        double p1 = table(j);
+        double p2 = table(j + 1);
+        if (_method == LINEAR) {
+            return p1 + t*(p2 - p1);
+        }
+
+        // the end intervals of a segment use ghost points extrapolated from a quadratic through its end nodes,
+        // its neighbour's nodes sit on the other side of a breakpoint so can't be used
+        double p0 = i > 0 ? table(j - 1) : 3*p1 - 3*p2 + table(j + 2);
+        double p3 = i + 2 < seg.n ? table(j + 2) : 3*p2 - 3*p1 + table(j - 1);
+        return p1 + 0.5*t*((p2 - p0) + t*((2*p0 - 5*p1 + 4*p2 - p3) + t*(3*(p1 - p2) + p3 - p0)));
+    }
+
+    void AtmosTable::lookup(const Eigen::ArrayXd& table, double (RealAtmos::*exact)(double), Eigen::Ref<const Eigen::ArrayXd> z, Eigen::Ref<Eigen::ArrayXd> out) const
+    {
+        for (Eigen::Index j = 0; j < z.size(); j++) {
+            out(j) = inRange(z(j)) ? lookup(table, z(j)) : (_atmos->*exact)(z(j));
+        }
+    }
+
+    double AtmosTable::measureError() const
+    {
+        auto relErr = [](double table, double exact) {
+            return std::abs(table - exact)/std::max(std::abs(exact), std::numeric_limits<double>::min());
+        };
+
+        double err = 0;
+        for (const Segment& seg : _segments) {
+            for (Eigen::Index i = 0; i < seg.n - 1; i++) {
+                for (double frac : {0.25, 0.5, 0.75}) {
+                    double z = seg.zLower + (i + frac)*seg.spacing;
+                    err = std::max(err, relErr(temperature(z), _atmos->temperature(z)));
+                    err = std::max(err, relErr(pressure(z), _atmos->pressure(z)));
+                    err = std::max(err, relErr(density(z), _atmos->density(z)));
+                    err = std::max(err, relErr(g(z), _atmos->g(z)));
+                    err = std::max(err, relErr(sound(z), _atmos->sound(z)));
+                    err = std::max(err, relErr(dynamic_viscosity(z), _atmos->dynamic_viscosity(z)));
+                    err = std::max(err, relErr(kinematic_viscosity(z), _atmos->kinematic_viscosity(z)));
+                }
+            }
+        }
+        return err;
+    }
+
+    double AtmosTable::temperature(double z) const
+    {
+        return inRange(z) ? lookup(_temperature, z) : _atmos->temperature(z);
+    }
+
+    double AtmosTable::pressure(double z) const
+    {
+        return inRange(z) ? lookup(_pressure, z) : _atmos->pressure(z);
+    }
+
+    double AtmosTable::density(double z) const
+    {
+        return inRange(z) ? lookup(_density, z) : _atmos->density(z);
+    }
+
+    double AtmosTable::g(double z) const
+    {
+        return inRange(z) ? lookup(_g, z) : _atmos->g(z);
+    }
+
+    double AtmosTable::sound(double z) const
+    {
+        return inRange(z) ? lookup(_sound, z) : _atmos->sound(z);
+    }
+
+    double AtmosTable::dynamic_viscosity(double z) const
+    {
+        return inRange(z) ? lookup(_dynamicViscosity, z) : _atmos->dynamic_viscosity(z);
+    }
+
+    double AtmosTable::kinematic_viscosity(double z) const
+    {
+        return inRange(z) ? lookup(_kinematicViscosity, z) : _atmos->kinematic_viscosity(z);
+    }
+
+    AtmosProperties AtmosTable::properties(double z) const
+    {
+        if (!inRange(z)) {
+            return _atmos->properties(z);
+        }
+        Eigen::Index i;
+        double t;
+        const Segment& seg = locate(z, i, t);
+        return {
+            interpolate(_temperature, seg, i, t),
+            interpolate(_pressure, seg, i, t),
+            interpolate(_density, seg, i, t),
+            interpolate(_g, seg, i, t),
+            interpolate(_sound, seg, i, t),
+            interpolate(_dynamicViscosity, seg, i, t),
+            interpolate(_kinematicViscosity, seg, i, t)
+        };
+    }
+
+    void AtmosTable::temperature(Eigen::Ref<const Eigen::ArrayXd> z, Eigen::Ref<Eigen::ArrayXd> out) const
+    {
+        lookup(_temperature, &RealAtmos::temperature, z, out);
+    }
+
+    void AtmosTable::pressure(Eigen::Ref<const Eigen::ArrayXd> z, Eigen::Ref<Eigen::ArrayXd> out) const
+    {
+        lookup(_pressure, &RealAtmos::pressure, z, out);
+    }
+
+    void AtmosTable::density(Eigen::Ref<const Eigen::ArrayXd> z, Eigen::Ref<Eigen::ArrayXd> out) const
+    {
+        lookup(_density, &RealAtmos::density, z, out);
+    }
+
+    void AtmosTable::g(Eigen::Ref<const Eigen::ArrayXd> z, Eigen::Ref<Eigen::ArrayXd> out) const
+    {
+        lookup(_g, &RealAtmos::g, z, out);
+    }
+
+    void AtmosTable::sound(Eigen::Ref<const Eigen::ArrayXd> z, Eigen::Ref<Eigen::ArrayXd> out) const
+    {
+        lookup(_sound, &RealAtmos::sound, z, out);
+    }
+
+    void AtmosTable::dynamic_viscosity(Eigen::Ref<const Eigen::ArrayXd> z, Eigen::Ref<Eigen::ArrayXd> out) const
+    {
+        lookup(_dynamicViscosity, &RealAtmos::dynamic_viscosity, z, out);
+    }
+
+    void AtmosTable::kinematic_viscosity(Eigen::Ref<const Eigen::ArrayXd> z, Eigen::Ref<Eigen::ArrayXd> out) const
+    {
+        lookup(_kinematicViscosity, &RealAtmos::kinematic_viscosity, z, out);
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "RealAtmos.hpp"
+#include <memory>
+#include <vector>
+#include <Eigen/Dense>
+
+namespace RealAtmos
+{
+    enum TableInterpolation
+    {
+        LINEAR,
+        CUBIC
+    };
+
+    /**
+     * Atmospheric properties sampled once onto an altitude grid that is uniform within each layer of the model.
+     * Every one of RealAtmos::breakpoints() in range is a grid node so no interval straddles a kink or jump in the model,
+     * lookups pick the layer then use O(1) index arithmetic followed by linear or cubic (Catmull-Rom) interpolation.
+     * Altitudes outside the grid fall through to the analytic model.
+     */
+    class AtmosTable
+    {
+        private:
+            // a run of evenly spaced nodes between two breakpoints
+            struct Segment
+            {
+                double zLower;
+                double spacing;
+                double invSpacing;
+                Eigen::Index first; // index of the segment's lowest node in the columns
+                Eigen::Index n; // number of nodes, never fewer than 3
+            };
+
+            RealAtmos* _atmos;
+            double _zMin;
+            double _zMax;
+            double _spacing;
+            TableInterpolation _method;
+            double _maxError = 0;
+            std::vector<Segment> _segments;
+
+            // one column per property, each segment's nodes are contiguous and the nodes either side of a breakpoint are kept separately
+            Eigen::ArrayXd _temperature;
+            Eigen::ArrayXd _pressure;
+            Eigen::ArrayXd _density;
+            Eigen::ArrayXd _g;
+            Eigen::ArrayXd _sound;
+            Eigen::ArrayXd _dynamicViscosity;
+            Eigen::ArrayXd _kinematicViscosity;
+
+            // finds the segment holding z, the interval i within it and the fraction t of the way across that interval
+            const Segment& locate(double z, Eigen::Index& i, double& t) const;
+            double lookup(const Eigen::ArrayXd& table, double z) const;
+            // interpolates within interval i of seg at fraction t of the way across it
+            double interpolate(const Eigen::ArrayXd& table, const Segment& seg, Eigen::Index i, double t) const;
+            void lookup(const Eigen::ArrayXd& table, double (RealAtmos::*exact)(double), Eigen::Ref<const Eigen::ArrayXd> z, Eigen::Ref<Eigen::ArrayXd> out) const;
+            inline bool inRange(double z) const { return z >= _zMin && z <= _zMax; }
+
+        public:
+            /**
+             * Samples every property of the analytic model onto the grid and measures the resulting interpolation error.
+             *
+             * @param atmos the analytic model to sample
+             * @param zMin lowest tabulated geometric altitude in meters
+             * @param zMax highest tabulated geometric altitude in meters
+             * @param spacing largest grid spacing in meters, each layer's spacing is shrunk so its nodes fit it exactly
+             * @param method interpolation used between grid points
+             */
+            AtmosTable(RealAtmos* atmos, double zMin = -5e3, double zMax = 86e3, double spacing = 10, TableInterpolation method = CUBIC);
+
+            /**
+             * Builds a table whose interpolation error is within a bound, the grid spacing is halved from initialSpacing until
+             * the largest relative error of any property against the analytic path is below tolerance or minSpacing is reached.
+             *
+             * @param tolerance allowable relative error
+             * @return std::shared_ptr<AtmosTable> check maxError() to see if the bound was met
+             */
+            static std::shared_ptr<AtmosTable> create(
+                RealAtmos* atmos, double tolerance = 1e-6, double zMin = -5e3, double zMax = 86e3,
+                TableInterpolation method = CUBIC, double initialSpacing = 100, double minSpacing = 0.5
+                );
+
+            /**
+             * Largest relative error of any property against the analytic model, measured at the quarter points of every interval.
+             *
+             * @return double
+             */
+            double measureError() const;
+
+            inline double maxError() const { return _maxError; }
+            inline double spacing() const { return _spacing; }
+            inline double zMin() const { return _zMin; }
+            inline double zMax() const { return _zMax; }
+            inline TableInterpolation method() const { return _method; }
+
+            // atmospheric property funcs, these mirror RealAtmos
+            double temperature(double z) const;
+            double pressure(double z) const;
+            double density(double z) const;
+            double g(double z) const;
+            double sound(double z) const;
+            double dynamic_viscosity(double z) const;
+            double kinematic_viscosity(double z) const;
+
+            // every property at once, the interval is found once and shared by every column
+            AtmosProperties properties(double z) const;
+
+            // batch lookups for several trajectories at once, out is filled with the property at each altitude in z
+            void temperature(Eigen::Ref<const Eigen::ArrayXd> z, Eigen::Ref<Eigen::ArrayXd> out) const;
+            void pressure(Eigen::Ref<const Eigen::ArrayXd> z, Eigen::Ref<Eigen::ArrayXd> out) const;
+            void density(Eigen::Ref<const Eigen::ArrayXd> z, Eigen::Ref<Eigen::ArrayXd> out) const;
+            void g(Eigen::Ref<const Eigen::ArrayXd> z, Eigen::Ref<Eigen::ArrayXd> out) const;
+            void sound(Eigen::Ref<const Eigen::ArrayXd> z, Eigen::Ref<Eigen::ArrayXd> out) const;
+            void dynamic_viscosity(Eigen::Ref<const Eigen::ArrayXd> z, Eigen::Ref<Eigen::ArrayXd> out) const;
+            void kinematic_viscosity(Eigen::Ref<const Eigen::ArrayXd> z, Eigen::Ref<Eigen::ArrayXd> out) const;
+    };
+}
@@ -0,0 +1,473 @@
+#include "batchSim.hpp"
+#include "maths.hpp"
+#include <cmath>
+#include <limits>
+
+namespace Sim{
+
+    // vector helpers for LaneVectors and LaneMatrices, each operates on every lane at once
+    template<typename V>
+    static V cross(const V& a, const V& b){
+        V res;
+        res.col(0) = a.col(1)*b.col(2) - a.col(2)*b.col(1);
+        res.col(1) = a.col(2)*b.col(0) - a.col(0)*b.col(2);
+        res.col(2) = a.col(0)*b.col(1) - a.col(1)*b.col(0);
+        return res;
+    }
+
+    template<typename V>
+    static auto dot(const V& a, const V& b){
+        return (a.col(0)*b.col(0) + a.col(1)*b.col(1) + a.col(2)*b.col(2)).eval();
+    }
+
+    template<typename V>
+    static auto norm(const V& a){
+        return dot(a, a).sqrt().eval();
+    }
+
+    // matches Eigen's normalized, a zero vector stays zero
+    template<typename V>
+    static V normalized(const V& a){
+        auto n = norm(a);
+        V res;
+        for(int i = 0; i < 3; i++){
+            res.col(i) = (n > 0).select(a.col(i)/n, 0.0);
+        }
+        return res;
+    }
+
+    template<typename M, typename V>
+    static V multiply(const M& m, const V& v){
+        V res;
+        for(int i = 0; i < 3; i++){
+            res.col(i) = m.col(3*i)*v.col(0) + m.col(3*i + 1)*v.col(1) + m.col(3*i + 2)*v.col(2);
+        }
+        return res;
+    }
+
+    // the transpose of m times v
+    template<typename M, typename V>
+    static V multiplyTransposed(const M& m, const V& v){
+        V res;
+        for(int i = 0; i < 3; i++){
+            res.col(i) = m.col(i)*v.col(0) + m.col(3 + i)*v.col(1) + m.col(6 + i)*v.col(2);
+        }
+        return res;
+    }
+
+    template<int Lanes>
+    BatchSim<Lanes>::BatchSim(std::array<RocketInterface*, Lanes> rockets, double timeStep){
+        _rockets = rockets;
+        _userStep = timeStep;
+        _atmos = RealAtmos::RealAtmos::GetInstance();
+        for(int l = 0; l < Lanes; l++){
+            _seeds[l] = 69;
+            _rotmats[l] = rockets[l] ? Sim::alignmentRotation(rockets[l]->thisWayUp(), thisWayUp()) : Eigen::Matrix3d::Identity();
+        }
+    }
+
+    template<int Lanes>
+    std::shared_ptr<BatchSim<Lanes>> BatchSim<Lanes>::create(std::array<RocketInterface*, Lanes> rockets, double timeStep){
+        auto obj = std::shared_ptr<BatchSim<Lanes>>(
+            new BatchSim<Lanes>(rockets, timeStep)
+        );
+        return obj;
+    }
+
+    template<int Lanes>
+    typename BatchSim<Lanes>::BatchState BatchSim<Lanes>::solve( const BatchState& initialConditions ){
+        for(int l = 0; l < Lanes; l++){
+            _active[l] = _rockets[l] != nullptr;
+            _takeoff[l] = false;
+            _onRod[l] = true;
+            _rngs[l].seed(_seeds[l]);
+            _summaries[l] = FlightSummary{};
+            Eigen::Vector3d rodVec = Utils::eulerToRotmat(initialConditions(Phi, l), initialConditions(Theta, l), initialConditions(Psi, l))*thisWayUp();
+            _rodVec.row(l) = rodVec.transpose();
+
+            RocketInterface* rocket = _rockets[l];
+            _massTables[l] = _tabulateMass && rocket ? std::make_shared<const MassTable>(rocket, _rotmats[l]) : nullptr;
+            // seeded as in Sim::solve so a lane meets the same gusts as the equivalent single flight
+            _turbulences[l] = _turbulenceSettings.enabled() && rocket ? Turbulence::generate(_turbulenceSettings, _seeds[l] ^ TURBULENCE_SEED_SALT) : nullptr;
+            _events[l] = EventLocator();
+            _events[l].add({ Events::RailExit, [this, l](double, const StateArray& y){ return stateArrayPosition(y).norm() - _rodLen[l]; }, 1, true });
+            if(_massTables[l]){
+                // as Sim::resetEvents, the table has already found the end of the burn
+                const double burnout = _massTables[l]->burnout();
+                _events[l].add({ Events::Burnout, [burnout](double t, const StateArray&){ return burnout - t; }, -1, true });
+            } else {
+                _events[l].add({ Events::Burnout, [rocket](double t, const StateArray&){ return rocket->thrust(FlightState(t, 0, 0, 0, 0, 0)).norm(); }, -1, true });
+            }
+            _events[l].add({ Events::Apogee, [](double, const StateArray& y){ return y[Zv]; }, -1, false });
+            _events[l].add({ Events::GroundImpact, [this, l](double, const StateArray& y){ return _takeoff[l] ? y[Zp] : 1.0; }, -1, true });
+        }
+
+        LaneArray apogee = initialConditions.row(Zp).transpose();
+        LaneArray apogeeTime = LaneArray::Zero();
+        BatchState state = initialConditions;
+
+        LaneArray step = LaneArray::Constant(userStep());
+        LaneArray time = LaneArray::Zero();
+        // the flow at each lane's first stage and end, and averaged over its last step as Sim averages its step data,
+        // the kpis are kept from the averages as Sim::fly keeps them
+        LaneArray k1Mach = LaneArray::Zero(), k1DynamicPressure = LaneArray::Zero();
+        LaneArray endMach = LaneArray::Zero(), endDynamicPressure = LaneArray::Zero();
+        LaneArray mach = LaneArray::Zero(), dynamicPressure = LaneArray::Zero();
+        BatchState k1 = calculate(time, state, _active, &k1Mach, &k1DynamicPressure);
+        for(int l = 0; l < Lanes; l++){
+            if(_active[l] && _kpis.test(Kpis::MaxMach)){
+                _summaries[l].maxMach = k1Mach[l];
+            }
+            if(_active[l] && _kpis.test(Kpis::MaxDynamicPressure)){
+                _summaries[l].maxDynamicPressure = k1DynamicPressure[l];
+            }
+        }
+        BatchState newState = state;
+        BatchState endK = k1;
+        std::array<std::vector<EventRecord>, Lanes> laneEvents;
+        // each lane's derivative scaled by its own step
+        auto scaled = [](const BatchState& k, const LaneArray& h) -> BatchState {
+            return k.rowwise()*h.transpose();
+        };
+        // RK4 across the lanes in the mask, each from its own time with its own step, the other lanes' results are left as they were
+        auto rk4 = [&](const LaneArray& h, const LaneMask& lanes){
+            LaneArray mach2 = LaneArray::Zero(), mach3 = LaneArray::Zero(), mach4 = LaneArray::Zero();
+            LaneArray pressure2 = LaneArray::Zero(), pressure3 = LaneArray::Zero(), pressure4 = LaneArray::Zero();
+            const BatchState k2 = calculate(time + h/2, state + scaled(k1, h/2), lanes, &mach2, &pressure2);
+            const BatchState k3 = calculate(time + h/2, state + scaled(k2, h/2), lanes, &mach3, &pressure3);
+            const BatchState k4 = calculate(time + h, state + scaled(k3, h), lanes, &mach4, &pressure4);
+            BatchState stepped = state + scaled(k1 + 2*k2 + 2*k3 + k4, h/6);
+            stepped = (std::numeric_limits<double>::epsilon() < stepped.abs()).select(stepped, 0);
+            const BatchState steppedK = calculate(time + h, stepped, lanes, &endMach, &endDynamicPressure);
+            for(int l = 0; l < Lanes; l++){
+                if(!lanes[l]){
+                    continue;
+                }
+                mach[l] = (k1Mach[l] + 2*mach2[l] + 2*mach3[l] + mach4[l])/6;
+                dynamicPressure[l] = (k1DynamicPressure[l] + 2*pressure2[l] + 2*pressure3[l] + pressure4[l])/6;
+                newState.col(l) = stepped.col(l);
+                endK.col(l) = steppedK.col(l);
+                const StateArray laneState = state.col(l);
+                const StateArray laneNewState = newState.col(l);
+                laneEvents[l] = _events[l].locate(DenseOutput::hermite(time[l], h[l], laneState, k1.col(l), laneNewState, endK.col(l)));
+            }
+        };
+        while(_active.any()){
+            const LaneMask stepping = _active;
+            step = stepping.select(selectTimeStep(k1, step), step);
+            rk4(step, stepping);
+
+            // each lane's step is cut at its own terminal event and retaken for that lane alone, as Sim cuts its own,
+            // so no lane's steps or random draws depend on the lanes it is batched with
+            LaneMask cut = LaneMask::Constant(false);
+            LaneArray cutStep = step;
+            for(int l = 0; l < Lanes; l++){
+                if(stepping[l] && !laneEvents[l].empty() && laneEvents[l].back().terminal){
+                    cut[l] = true;
+                    cutStep[l] = laneEvents[l].back().before - time[l];
+                }
+            }
+            LaneArray newTime = time + step;
+            if(cut.any()){
+                const std::array<std::vector<EventRecord>, Lanes> cutEvents = laneEvents;
+                rk4(cutStep, cut);
+                for(int l = 0; l < Lanes; l++){
+                    if(cut[l]){
+                        laneEvents[l] = cutEvents[l];
+                        newTime[l] = laneEvents[l].back().time;
+                        laneEvents[l].back().state = newState.col(l);
+                    }
+                }
+            }
+
+            const LaneMask wasTakeoff = _takeoff;
+            const LaneMask wasOnRod = _onRod;
+            for(int l = 0; l < Lanes; l++){
+                // finished lanes are held where they stopped
+                if(!stepping[l]){
+                    continue;
+                }
+                if(!_takeoff[l] && newState(Zv, l) > 0){
+                    _takeoff[l] = true;
+                }
+                for(auto e = laneEvents[l].begin(); e != laneEvents[l].end() && _active[l]; e++){
+                    _events[l].fire(*e);
+                    if(e->id == Events::RailExit){
+                        _onRod[l] = false;
+                        if(_kpis.test(Kpis::RailExitVelocity)){
+                            _summaries[l].railExitVelocity = stateArrayVelocity(e->state).norm();
+                        }
+                    } else if(e->id == Events::GroundImpact){
+                        // the lane ends at its located impact rather than the end of its step
+                        newState.col(l) = e->state;
+                        _summaries[l].flightTime = e->time;
+                        _active[l] = false;
+                        if(_kpis.test(Kpis::LandingPosition)){
+                            _summaries[l].landingPosition = stateArrayPosition(e->state);
+                        }
+                    }
+                }
+                // terminating on max steps, after as many steps as Sim takes and marked as unfinished as Sim marks it
+                if(_active[l] && _summaries[l].steps >= Sim::MAX_STEPS){
+                    _summaries[l].flightTime = newTime[l];
+                    _summaries[l].stepLimited = true;
+                    _active[l] = false;
+                }
+                _summaries[l].steps++;
+                if(newState(Zp, l) > apogee[l]){
+                    apogee[l] = newState(Zp, l);
+                    apogeeTime[l] = newTime[l];
+                }
+                if(_kpis.test(Kpis::MaxMach)){
+                    _summaries[l].maxMach = std::max(_summaries[l].maxMach, mach[l]);
+                }
+                if(_kpis.test(Kpis::MaxDynamicPressure)){
+                    _summaries[l].maxDynamicPressure = std::max(_summaries[l].maxDynamicPressure, dynamicPressure[l]);
+                }
+            }
+
+            time = stepping.select(newTime, time);
+            state = newState;
+
+            // the end derivative was found with the old flags and at the uncut time so it can't always be reused,
+            // only the lanes that need it are evaluated again
+            k1 = endK;
+            k1Mach = endMach;
+            k1DynamicPressure = endDynamicPressure;
+            const LaneMask refresh = _active && (cut || wasTakeoff != _takeoff || wasOnRod != _onRod);
+            if(refresh.any()){
+                const BatchState fresh = calculate(time, state, refresh, &k1Mach, &k1DynamicPressure);
+                for(int l = 0; l < Lanes; l++){
+                    if(refresh[l]){
+                        k1.col(l) = fresh.col(l);
+                        _events[l].invalidate();
+                    }
+                }
+            }
+        }
+
+        for(int l = 0; l < Lanes; l++){
+            FlightSummary& summary = _summaries[l];
+            summary.apogee = apogee[l];
+            summary.apogeeTime = apogeeTime[l];
+            if(_events[l].fired(Events::Apogee)){
+                summary.apogee = _events[l].record(Events::Apogee).state[Zp];
+                summary.apogeeTime = _events[l].record(Events::Apogee).time;
+            }
+            if(_events[l].fired(Events::RailExit)){
+                summary.railExitTime = _events[l].record(Events::RailExit).time;
+            }
+            if(_events[l].fired(Events::Burnout)){
+                summary.burnoutTime = _events[l].record(Events::Burnout).time;
+            }
+        }
+        return state;
+    }
+
+    template<int Lanes>
+    typename BatchSim<Lanes>::LaneArray BatchSim<Lanes>::selectTimeStep( const BatchState& k1, const LaneArray& currStep ) const {
+        static const double maxAngleStep = 3 * M_PI / 180; // 3 degrees
+        static const double maxPitchStepChange = 4 * M_PI / 180; // 4 degrees
+        static const double minTimeStep = 0.001;
+
+        // rail exit is located on each step's interpolant so the rod no longer needs a shorter step
+        const LaneArray userCandidate = LaneArray::Constant(std::max(userStep(), minTimeStep));
+        const LaneArray kTheta = k1.row(Theta).transpose();
+        const LaneArray kPsi = k1.row(Psi).transpose();
+        const LaneArray kdTheta = k1.row(dTheta).transpose();
+        const LaneArray kdPsi = k1.row(dPsi).transpose();
+        const LaneArray angleCandidate = (maxAngleStep/(kTheta.square() + kPsi.square()).sqrt()).abs();
+        const LaneArray rateCandidate = (maxPitchStepChange/(kdTheta.square() + kdPsi.square()).sqrt()).abs();
+
+        return userCandidate.min(angleCandidate).min(rateCandidate).min(1.5*currStep);
+    }
+
+    template<int Lanes>
+    typename BatchSim<Lanes>::BatchState BatchSim<Lanes>::calculate( const LaneArray& time, const BatchState& state, const LaneMask& lanes, LaneArray* machOut, LaneArray* dynamicPressureOut ){
+        const double gam = 1.4;
+
+        // unpacking the state, each component becomes a contiguous array over the lanes
+        LaneVectors position, velocity, orientation, angVelocity;
+        position << state.row(Xp).transpose(), state.row(Yp).transpose(), state.row(Zp).transpose();
+        velocity << state.row(Xv).transpose(), state.row(Yv).transpose(), state.row(Zv).transpose();
+        orientation << state.row(Phi).transpose(), state.row(Theta).transpose(), state.row(Psi).transpose();
+        angVelocity << state.row(dPhi).transpose(), state.row(dTheta).transpose(), state.row(dPsi).transpose();
+
+        // rotation matrices of every lane, the expanded form of Utils::eulerToRotmat
+        const LaneArray cx = orientation.col(0).cos(), sx = orientation.col(0).sin();
+        const LaneArray cy = orientation.col(1).cos(), sy = orientation.col(1).sin();
+        const LaneArray cz = orientation.col(2).cos(), sz = orientation.col(2).sin();
+        LaneMatrices rotation;
+        rotation << cz*cy, cz*sy*sx - sz*cx, cz*sy*cx + sz*sx,
+                    sz*cy, sz*sy*sx + cz*cx, sz*sy*cx - cz*sx,
+                    -sy, cy*sx, cy*cx;
+        // the rockets current "up" vector in global coords, the third column as up is z
+        LaneVectors rocketOrientationVec;
+        rocketOrientationVec << rotation.col(2), rotation.col(5), rotation.col(8);
+
+        // getting atmospheric properties
+        LaneVectors centerOfEarth = LaneVectors::Zero();
+        centerOfEarth.col(2).setConstant(-RealAtmos::R_0);
+        const LaneVectors toCenter = centerOfEarth - position;
+        const LaneArray alt = norm(toCenter) - RealAtmos::R_0;
+        LaneArray g, atmDens, cSound, kinVisc;
+        if(_atmosTable){
+            _atmosTable->g(alt, g);
+            _atmosTable->density(alt, atmDens);
+            _atmosTable->sound(alt, cSound);
+            _atmosTable->kinematic_viscosity(alt, kinVisc);
+        } else {
+            RealAtmos::AtmosPropertiesArray<Lanes> atmos;
+            _atmos->properties(alt, atmos);
+            g = atmos.g;
+            atmDens = atmos.density;
+            cSound = atmos.sound;
+            kinVisc = atmos.kinematic_viscosity;
+        }
+
+        // the wind tables are looked up lane by lane, as Sim::wind
+        LaneVectors windVel = LaneVectors::Zero();
+        if(_windProfile || _turbulenceSettings.enabled()){
+            for(int l = 0; l < Lanes; l++){
+                if(!lanes[l]){
+                    continue;
+                }
+                Eigen::Vector3d laneWind = _windProfile ? _windProfile->at(alt[l]) : Eigen::Vector3d::Zero();
+                if(_turbulences[l]){
+                    laneWind += _turbulences[l]->at(time[l]);
+                }
+                windVel.row(l) = laneWind.transpose();
+            }
+        }
+        const LaneVectors relativeVelocity = velocity - windVel;
+        const LaneArray relativeSpeed = norm(relativeVelocity);
+        const LaneArray mach = relativeSpeed/cSound;
+        const LaneArray dynamicPressure = atmDens*relativeSpeed.square()/2;
+        if(machOut){
+            *machOut = lanes.select(mach, *machOut);
+        }
+        if(dynamicPressureOut){
+            *dynamicPressureOut = lanes.select(dynamicPressure, *dynamicPressureOut);
+        }
+
+        const LaneVectors normRelVelVec = normalized(relativeVelocity);
+        const LaneArray cosAoA = (dot(normRelVelVec, rocketOrientationVec)/(norm(normRelVelVec)*norm(rocketOrientationVec))).max(-1.0).min(1.0);
+        const LaneArray angleOfAttack = (_onRod || relativeSpeed == 0).select(0.0, cosAoA.acos());
+        const LaneArray reynL = relativeSpeed/kinVisc;
+
+        // the rocket is asked lane by lane, everything else is done across lanes
+        LaneArray aRef, lRef, m, cn, yawDampingCoeff, pitchDampingCoeff, cd, randPitchCoeff, randYawCoeff;
+        LaneVectors thrustLocal, rockCP, rockCM;
+        LaneMatrices inverseInertia;
+        std::uniform_real_distribution<double> randMomentDist(-0.0005, 0.0005);
+        for(int l = 0; l < Lanes; l++){
+            if(!lanes[l]){
+                aRef[l] = 0; lRef[l] = 0; m[l] = 1; cn[l] = 0; yawDampingCoeff[l] = 0; pitchDampingCoeff[l] = 0; cd[l] = 0;
+                randPitchCoeff[l] = 0; randYawCoeff[l] = 0;
+                thrustLocal.row(l).setZero(); rockCP.row(l).setZero(); rockCM.row(l).setZero();
+                inverseInertia.row(l) << 1, 0, 0, 0, 1, 0, 0, 0, 1;
+                continue;
+            }
+            RocketInterface* rocket = _rockets[l];
+            const Eigen::Matrix3d& rotmat = _rotmats[l];
+            const FlightState currState = FlightState(
+                time[l], mach[l], angleOfAttack[l], angVelocity(l, 0), angVelocity(l, 1), reynL[l], gam
+            );
+            const RocketSnapshot rocketVals = rocket->evaluate(currState, !_massTables[l]);
+            aRef[l] = rocketVals.referenceArea;
+            lRef[l] = rocketVals.referenceLength;
+            const MassProperties massProps = _massTables[l] ? _massTables[l]->at(time[l]) : MassTable::evaluate(rocketVals, rotmat);
+            m[l] = massProps.mass;
+            const Eigen::Matrix3d& inverse = massProps.inverseInertia;
+            for(int r = 0; r < 3; r++){
+                for(int c = 0; c < 3; c++){
+                    inverseInertia(l, 3*r + c) = inverse(r, c);
+                }
+            }
+            thrustLocal.row(l) = (rotmat*rocketVals.thrust).transpose();
+            cn[l] = rocketVals.c_n;
+            rockCP.row(l) = (rotmat*rocketVals.cp).transpose();
+            rockCM.row(l) = massProps.cm.transpose();
+            yawDampingCoeff[l] = rocketVals.c_m_damp_yaw;
+            pitchDampingCoeff[l] = rocketVals.c_m_damp_pitch;
+            cd[l] = rocketVals.Cdf + rocketVals.Cdp + rocketVals.Cdb;
+            // drawn in the same order as Sim::calculate
+            randPitchCoeff[l] = randMomentDist(_rngs[l]);
+            randYawCoeff[l] = randMomentDist(_rngs[l]);
+        }
+
+        // thrust and gravity
+        LaneVectors forces = multiply(rotation, thrustLocal);
+        LaneVectors acceleration = normalized(toCenter);
+        for(int i = 0; i < 3; i++){
+            acceleration.col(i) *= g;
+        }
+
+        // normal forces
+        const LaneVectors normDirCandidate = normalized(cross(rocketOrientationVec, cross(rocketOrientationVec, LaneVectors(relativeVelocity - rocketOrientationVec))));
+        const LaneArray normForceMag = cn*aRef*dynamicPressure;
+        LaneVectors normForce;
+        for(int i = 0; i < 3; i++){
+            normForce.col(i) = (angleOfAttack <= std::numeric_limits<double>::epsilon()).select(0.0, normForceMag*normDirCandidate.col(i));
+        }
+        forces += normForce;
+        LaneVectors moments = cross(multiplyTransposed(rotation, normForce), LaneVectors(rockCM - rockCP));
+
+        // damping opposes the angular velocity, with the same axis pairing as Sim::calculate
+        const LaneArray dampingScale = aRef*lRef*dynamicPressure;
+        const LaneArray yawDamping = yawDampingCoeff*dampingScale;
+        const LaneArray pitchDamping = pitchDampingCoeff*dampingScale;
+        moments.col(0) += (angVelocity.col(0) < 0).select(yawDamping, -yawDamping);
+        moments.col(1) += (angVelocity.col(2) < 0).select(pitchDamping, -pitchDamping);
+
+        // drag
+        const LaneVectors dragDir = -normalized(relativeVelocity);
+        const LaneArray dragMag = cd*aRef*dynamicPressure;
+        LaneVectors dragForce;
+        for(int i = 0; i < 3; i++){
+            dragForce.col(i) = dragMag*dragDir.col(i);
+        }
+        forces += dragForce;
+        moments += cross(multiplyTransposed(rotation, dragForce), LaneVectors(rockCP - rockCM));
+
+        // consolidating forces and moments
+        for(int i = 0; i < 3; i++){
+            acceleration.col(i) += forces.col(i)/m;
+        }
+        moments.col(0) += randYawCoeff*dampingScale;
+        moments.col(1) += randPitchCoeff*dampingScale;
+        LaneVectors angAcceleration = multiply(inverseInertia, moments);
+
+        // adjusting for takeoff
+        acceleration.col(2) = (!_takeoff && acceleration.col(2) < 0).select(0.0, acceleration.col(2));
+
+        // adjusting for onRod
+        const LaneArray accelerationMag = norm(acceleration);
+        for(int i = 0; i < 3; i++){
+            acceleration.col(i) = _onRod.select(accelerationMag*_rodVec.col(i), acceleration.col(i));
+            angAcceleration.col(i) = _onRod.select(0.0, angAcceleration.col(i));
+        }
+
+        BatchState res = BatchState::Zero();
+        res.row(Xp) = state.row(Xv);
+        res.row(Yp) = state.row(Yv);
+        res.row(Zp) = state.row(Zv);
+        res.row(Phi) = state.row(dPhi);
+        res.row(Theta) = state.row(dTheta);
+        res.row(Psi) = state.row(dPsi);
+        res.row(Xv) = acceleration.col(0).transpose();
+        res.row(Yv) = acceleration.col(1).transpose();
+        res.row(Zv) = acceleration.col(2).transpose();
+        res.row(dPhi) = angAcceleration.col(0).transpose();
+        res.row(dTheta) = angAcceleration.col(1).transpose();
+        res.row(dPsi) = angAcceleration.col(2).transpose();
+        // lanes that were not asked for do not move
+        for(int i = 0; i < StateMappings::LAST; i++){
+            res.row(i) = lanes.transpose().select(res.row(i), 0.0);
+        }
+        return res;
+    }
+
+    template class BatchSim<4>;
+    template class BatchSim<8>;
+}
@@ -0,0 +1,157 @@
+#ifndef BATCH_SIM_H_
+#define BATCH_SIM_H_
+
+#include "simulation.hpp"
+#include "rocketInterface.hpp"
+#include "stateArray.hpp"
+#include "events.hpp"
+#include "RealAtmos.hpp"
+#include "atmosTable.hpp"
+#include "massTable.hpp"
+#include "wind.hpp"
+#include <array>
+#include <memory>
+#include <random>
+#include <Eigen/Dense>
+
+namespace Sim{
+
+    /**
+     * @brief Flies Lanes trajectories in lockstep so the kinematics, atmosphere and force assembly run across all of them at once
+     * the state is stored structure of arrays, 12 x Lanes with each component's lanes contiguous, so the per lane arithmetic vectorizes.
+     * only the rocket's coefficient calls are made lane by lane as they are virtual.
+     * each lane keeps its own time and RK4 step, chosen and cut at terminal events as Sim chooses and cuts them, and a cut step is retaken
+     * for its lane alone, so a lane flies the same steps and draws the same random numbers whatever it is batched with.
+     * lanes that have landed are masked out and stop changing
+     */
+    template<int Lanes>
+    class BatchSim{
+        public:
+            // one value per lane
+            using LaneArray = Eigen::Array<double, Lanes, 1>;
+            using LaneMask = Eigen::Array<bool, Lanes, 1>;
+            // a 3 vector per lane, one column per component
+            using LaneVectors = Eigen::Array<double, Lanes, 3>;
+            // a 3x3 matrix per lane, column 3*row + col holds that element
+            using LaneMatrices = Eigen::Array<double, Lanes, 9>;
+            // one row per state component, each holding that component for every lane
+            using BatchState = Eigen::Array<double, StateMappings::LAST, Lanes, Eigen::RowMajor>;
+
+        private:
+            std::array<RocketInterface*, Lanes> _rockets;
+            std::array<Eigen::Matrix3d, Lanes> _rotmats; // the rotation from each rockets design coords to the sims
+            double _userStep;
+            LaneArray _rodLen = LaneArray::Constant(0.1);
+            LaneVectors _rodVec = LaneVectors::Zero();
+
+            // lane flags
+            LaneMask _active = LaneMask::Constant(false);
+            LaneMask _takeoff = LaneMask::Constant(false);
+            LaneMask _onRod = LaneMask::Constant(true);
+
+            std::array<std::mt19937_64::result_type, Lanes> _seeds;
+            std::array<std::mt19937_64, Lanes> _rngs;
+            std::array<FlightSummary, Lanes> _summaries;
+            std::array<EventLocator, Lanes> _events;
+
+            RealAtmos::RealAtmos* _atmos;
+            std::shared_ptr<const RealAtmos::AtmosTable> _atmosTable = nullptr;
+            bool _tabulateMass = true;
+            std::array<std::shared_ptr<const MassTable>, Lanes> _massTables; // rebuilt for each lane at the start of every solve
+
+            Kpis::KpiMask _kpis = Kpis::allKpis();
+
+            std::shared_ptr<const WindProfile> _windProfile = nullptr;
+            TurbulenceSettings _turbulenceSettings;
+            std::array<std::shared_ptr<const Turbulence>, Lanes> _turbulences; // each lane's gusts, generated from its seed every solve
+
+            BatchSim(std::array<RocketInterface*, Lanes> rockets, double timeStep);
+
+        public:
+            /**
+             * @brief Creates a batch, a nullptr rocket leaves its lane empty so partial batches can be flown
+             *
+             * @param rockets the rocket flown in each lane
+             * @param timeStep the user step, as for Sim
+             * @return std::shared_ptr<BatchSim>
+             */
+            static std::shared_ptr<BatchSim> create(std::array<RocketInterface*, Lanes> rockets, double timeStep);
+
+            inline Eigen::Vector3d thisWayUp() const { return Eigen::Vector3d{0,0,1}; }
+
+            inline const double userStep() const {
+                return _userStep;
+            }
+
+            inline void setRodLen( int lane, double rodLen ) {
+                _rodLen[lane] = rodLen;
+            }
+
+            // each lane has its own generator, reseeded at the start of every solve
+            inline void setSeed( int lane, std::mt19937_64::result_type seed ) {
+                _seeds[lane] = seed;
+            }
+
+            inline void setAtmosTable( std::shared_ptr<const RealAtmos::AtmosTable> table ) {
+                _atmosTable = table;
+            }
+
+            // as Sim::setTabulateMass, applies to every lane
+            inline void setTabulateMass( bool tabulate ) {
+                _tabulateMass = tabulate;
+            }
+
+            // as Sim::setWindProfile, every lane flies through the same mean wind
+            inline void setWindProfile( std::shared_ptr<const WindProfile> profile ) {
+                _windProfile = profile;
+            }
+
+            // as Sim::setTurbulenceSettings, each lane draws its own gusts from its seed exactly as a Sim with that seed would
+            inline void setTurbulenceSettings( TurbulenceSettings settings ) {
+                _turbulenceSettings = settings;
+            }
+
+            // as Sim::setKpis, applies to every lane
+            inline void setKpis( Kpis::KpiMask kpis ) {
+                _kpis = kpis;
+            }
+
+            // results of the last solve for a lane
+            inline const FlightSummary& summary( int lane ) const {
+                return _summaries[lane];
+            }
+
+            inline const EventLocator& events( int lane ) const {
+                return _events[lane];
+            }
+
+            /**
+             * @brief Integrates every lane from its initial conditions until it lands
+             *
+             * @param initialConditions one column of initial conditions per lane
+             * @return BatchState the state of each lane at termination
+             */
+            BatchState solve( const BatchState& initialConditions );
+
+            /**
+             * @brief Calculates the derivative of the lanes in a mask, mirroring Sim::calculate, the other lanes are left at zero
+             * and draw nothing from their generators
+             *
+             * @param time the time each lane is calculated at
+             * @param state the state of every lane
+             * @param lanes the lanes to calculate
+             * @param machOut when set, each calculated lane's mach number is written here
+             * @param dynamicPressureOut when set, each calculated lane's dynamic pressure is written here
+             * @return BatchState
+             */
+            BatchState calculate( const LaneArray& time, const BatchState& state, const LaneMask& lanes, LaneArray* machOut = nullptr, LaneArray* dynamicPressureOut = nullptr );
+
+            // each lane's next step, as Sim::selectTimeStep would choose it for that lane
+            LaneArray selectTimeStep( const BatchState& k1, const LaneArray& currStep ) const;
+    };
+
+    extern template class BatchSim<4>;
+    extern template class BatchSim<8>;
+}
+
+#endif
@@ -0,0 +1,158 @@
+#include "checkpoint.hpp"
+#include "simulation.hpp"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace Sim{
+
+    static const char FILE_MAGIC[8] = { 'F', 'S', 'C', 'K', 'P', 'T', '\0', '\0' };
+    static const uint32_t FILE_VERSION = 1;
+
+    struct FILE_HEADER{
+        char magic[8];
+        uint32_t version;
+        uint32_t stateSize; // a checkpoint only loads into a build with the same state and telemetry layout
+        uint32_t dataSize;
+    };
+
+    // fixed size values, including the fixed size eigen types, are written as their bytes
+    template<typename T>
+    static void put(std::ostream& file, const T& value){
+        static_assert(std::is_trivially_copyable_v<T> || std::is_base_of_v<Eigen::DenseBase<T>, T> || std::is_same_v<T, Eigen::Quaterniond>);
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    static bool get(std::istream& file, T& value){
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    // sizes are checked against this when reading so a corrupt file can't cause a huge allocation
+    static const uint64_t MAX_ENTRIES = 1 << 20;
+
+    static bool getSize(std::istream& file, uint64_t& size){
+        return get(file, size) && size <= MAX_ENTRIES;
+    }
+
+    // flags are written as a byte each, anything but 0 or 1 is a corrupt file rather than a bool
+    static void putFlag(std::ostream& file, bool value){
+        put(file, static_cast<uint8_t>(value));
+    }
+
+    static bool getFlag(std::istream& file, bool& value){
+        uint8_t byte = 0;
+        if(!get(file, byte) || byte > 1){
+            return false;
+        }
+        value = byte == 1;
+        return true;
+    }
+
+    void Checkpoint::save(const std::filesystem::path& path) const {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if(!file){
+            throw std::runtime_error("could not open " + path.string() + " to save the checkpoint");
+        }
+        FILE_HEADER header;
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.version = FILE_VERSION;
+        header.stateSize = StateMappings::LAST;
+        header.dataSize = Telemetry::LAST;
+        put(file, header);
+
+        put(file, time); put(file, step); put(file, state); put(file, derivative); put(file, derivativeData);
+        put(file, counter); put(file, compTime);
+
+        putFlag(file, onRod); putFlag(file, takeoff); put(file, rodVector);
+        put(file, static_cast<uint64_t>(events.size()));
+        for(auto e = events.cbegin(); e != events.cend(); e++){
+            put(file, static_cast<int32_t>(e->id)); put(file, e->time); put(file, e->before); put(file, e->state); putFlag(file, e->terminal);
+        }
+
+        put(file, seed);
+        put(file, static_cast<uint64_t>(rng.size()));
+        file.write(rng.data(), rng.size());
+
+        put(file, integrator); put(file, attitudeRepresentation); put(file, attitudeReference);
+        put(file, lastError); putFlag(file, lastRejected);
+        put(file, static_cast<uint64_t>(nordsieck.size()));
+        for(auto n = nordsieck.cbegin(); n != nordsieck.cend(); n++){
+            put(file, *n);
+        }
+        put(file, abmOrder); put(file, abmStep); put(file, abmStepsSinceChange); put(file, abmLastCorrection); putFlag(file, abmRestart);
+        put(file, static_cast<uint64_t>(history.size()));
+        for(auto h = history.cbegin(); h != history.cend(); h++){
+            put(file, h->first); put(file, h->second);
+        }
+
+        put(file, apogee); put(file, apogeeTime);
+        put(file, maxMach); put(file, maxDynamicPressure); put(file, railExitVelocity); put(file, landingPosition);
+        if(!file){
+            throw std::runtime_error("could not write the checkpoint to " + path.string());
+        }
+    }
+
+    std::optional<Checkpoint> Checkpoint::load(const std::filesystem::path& path){
+        std::ifstream file(path, std::ios::binary);
+        FILE_HEADER header;
+        if(!get(file, header)){
+            return std::nullopt;
+        }
+        if(std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FILE_VERSION
+            || header.stateSize != StateMappings::LAST || header.dataSize != Telemetry::LAST){
+            return std::nullopt;
+        }
+
+        Checkpoint cp;
+        uint64_t size = 0;
+        bool ok = get(file, cp.time) && get(file, cp.step) && get(file, cp.state) && get(file, cp.derivative) && get(file, cp.derivativeData)
+            && get(file, cp.counter) && get(file, cp.compTime);
+
+        ok = ok && getFlag(file, cp.onRod) && getFlag(file, cp.takeoff) && get(file, cp.rodVector) && getSize(file, size);
+        for(uint64_t i = 0; ok && i < size; i++){
+            EventRecord record;
+            int32_t id = 0;
+            ok = get(file, id) && id >= 0 && id < Events::LAST && get(file, record.time) && get(file, record.before)
+                && get(file, record.state) && getFlag(file, record.terminal);
+            record.id = static_cast<Events::FlightEvents>(id);
+            cp.events.push_back(record);
+        }
+
+        ok = ok && get(file, cp.seed) && getSize(file, size);
+        if(ok){
+            cp.rng.resize(size);
+            ok = static_cast<bool>(file.read(cp.rng.data(), size));
+        }
+
+        ok = ok && get(file, cp.integrator) && get(file, cp.attitudeRepresentation) && get(file, cp.attitudeReference)
+            && get(file, cp.lastError) && getFlag(file, cp.lastRejected) && getSize(file, size);
+        // only the integrators and attitude representations solve flies are valid
+        ok = ok && (cp.integrator == RK4 || cp.integrator == AB || cp.integrator == DP45 || cp.integrator == ABM)
+            && (cp.attitudeRepresentation == EULER_ANGLES || cp.attitudeRepresentation == QUATERNION);
+        if(ok){
+            cp.nordsieck.resize(size);
+        }
+        for(uint64_t i = 0; ok && i < size; i++){
+            ok = get(file, cp.nordsieck[i]);
+        }
+        ok = ok && get(file, cp.abmOrder) && get(file, cp.abmStep) && get(file, cp.abmStepsSinceChange) && get(file, cp.abmLastCorrection)
+            && getFlag(file, cp.abmRestart) && getSize(file, size);
+        // the adams order indexes the nordsieck vector
+        ok = ok && cp.abmOrder >= 1 && static_cast<size_t>(cp.abmOrder) < cp.nordsieck.size();
+        if(ok){
+            cp.history.resize(size);
+        }
+        for(uint64_t i = 0; ok && i < size; i++){
+            ok = get(file, cp.history[i].first) && get(file, cp.history[i].second);
+        }
+
+        ok = ok && get(file, cp.apogee) && get(file, cp.apogeeTime)
+            && get(file, cp.maxMach) && get(file, cp.maxDynamicPressure) && get(file, cp.railExitVelocity) && get(file, cp.landingPosition);
+        if(!ok){
+            return std::nullopt;
+        }
+        return cp;
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include "stateArray.hpp"
+#include "telemetry.hpp"
+#include "events.hpp"
+#include "nanValues.hpp"
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <Eigen/Dense>
+
+namespace Sim{
+
+    class RocketInterface;
+
+    /**
+     * @brief Everything a solve carries from one accepted step to the next, so a flight can be carried on from it with Sim::resume
+     * resuming with the same rocket and settings reproduces the rest of the original flight exactly
+     */
+    struct Checkpoint{
+        // where the flight is
+        double time = 0;
+        double step = 0; // the step the controller proposed next
+        StateArray state = StateArray::Zero(); // in the layout solve integrates, see Sim::setAttitudeRepresentation
+        StateArray derivative = StateArray::Zero(); // at state, reused as the first stage of the next step
+        StepData derivativeData = StepData::Zero();
+        int counter = 0; // accepted steps so far
+        int64_t compTime = 0; // microseconds spent integrating so far
+        // the rocket the derivative came from, not saved, so a loaded checkpoint is taken to be resumed with the rocket that took it
+        const RocketInterface* rocket = nullptr;
+
+        // phase flags
+        bool onRod = true;
+        bool takeoff = false;
+        Eigen::Vector3d rodVector = Eigen::Vector3d::UnitZ();
+        std::vector<EventRecord> events; // fired so far, in the order they occurred
+
+        // the generator as written by operator<< along with the seed the gusts were drawn from
+        uint64_t seed = 0;
+        std::string rng;
+
+        // integrator settings and memory
+        int integrator = 0; // an IntegrationStrats
+        int attitudeRepresentation = 0; // an AttitudeRepresentations
+        Eigen::Quaterniond attitudeReference = Eigen::Quaterniond::Identity();
+        double lastError = 1e-4;
+        bool lastRejected = false;
+        std::vector<StateArray> nordsieck;
+        int abmOrder = 1;
+        double abmStep = 0;
+        int abmStepsSinceChange = 0;
+        StateArray abmLastCorrection = StateArray::Zero();
+        bool abmRestart = true;
+        std::vector<std::pair<double, StateArray>> history; // the multistep history as step and derivative pairs, oldest first
+
+        // the flight summary so far
+        double apogee = 0;
+        double apogeeTime = 0;
+        double maxMach = NAN_D;
+        double maxDynamicPressure = NAN_D;
+        double railExitVelocity = NAN_D;
+        Eigen::Vector3d landingPosition = Eigen::Vector3d::Constant(NAN_D);
+
+        // writes the checkpoint to a file, throws std::runtime_error if it cannot be written
+        void save(const std::filesystem::path& path) const;
+
+        /**
+         * @brief Reads a checkpoint written by save
+         *
+         * @param path the file to read
+         * @return std::optional<Checkpoint> nothing if the file is missing or is not a valid checkpoint
+         */
+        static std::optional<Checkpoint> load(const std::filesystem::path& path);
+    };
+}
+
+#endif
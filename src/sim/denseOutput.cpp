@@ -0,0 +1,27 @@
+#include "denseOutput.hpp"
+
+namespace Sim{
+
+    DenseOutput::DenseOutput(double t0, double h, const StateArray& r1, const StateArray& r2, const StateArray& r3, const StateArray& r4, const StateArray& r5){
+        _t0 = t0;
+        _h = h;
+        _r1 = r1;
+        _r2 = r2;
+        _r3 = r3;
+        _r4 = r4;
+        _r5 = r5;
+    }
+
+    DenseOutput DenseOutput::hermite(double t0, double h, const StateArray& y0, const StateArray& f0, const StateArray& y1, const StateArray& f1){
+        StateArray r2 = y1 - y0;
+        StateArray r3 = h*f0 - r2;
+        StateArray r4 = r2 - h*f1 - r3;
+        return DenseOutput(t0, h, y0, r2, r3, r4, StateArray::Zero());
+    }
+
+    StateArray DenseOutput::operator()(double time) const {
+        double theta = (time - _t0)/_h;
+        double theta1 = 1 - theta;
+        return _r1 + theta*(_r2 + theta1*(_r3 + theta*(_r4 + theta1*_r5)));
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef DENSE_OUTPUT_H_
+#define DENSE_OUTPUT_H_
+
+#include "stateArray.hpp"
+
+namespace Sim{
+
+    /**
+     * @brief Continuous approximation of the state over one accepted step
+     * the polynomial is stored in Hairer's form, with theta = (t - t0)/h
+     * y(t) = r1 + theta*(r2 + (1 - theta)*(r3 + theta*(r4 + (1 - theta)*r5)))
+     * which is a cubic Hermite interpolant when r5 is zero and the Dormand-Prince continuous extension otherwise
+     */
+    class DenseOutput{
+        private:
+            double _t0 = 0;
+            double _h = 0;
+            StateArray _r1 = StateArray::Zero();
+            StateArray _r2 = StateArray::Zero();
+            StateArray _r3 = StateArray::Zero();
+            StateArray _r4 = StateArray::Zero();
+            StateArray _r5 = StateArray::Zero();
+
+        public:
+            DenseOutput() = default;
+            DenseOutput(double t0, double h, const StateArray& r1, const StateArray& r2, const StateArray& r3, const StateArray& r4, const StateArray& r5);
+
+            /**
+             * @brief Cubic Hermite interpolant matching the state and its derivative at both ends of the step
+             *
+             * @param t0 time at the start of the step
+             * @param h step size
+             * @param y0 state at the start of the step
+             * @param f0 derivative at the start of the step
+             * @param y1 state at the end of the step
+             * @param f1 derivative at the end of the step
+             * @return DenseOutput
+             */
+            static DenseOutput hermite(double t0, double h, const StateArray& y0, const StateArray& f0, const StateArray& y1, const StateArray& f1);
+
+            inline double t0() const { return _t0; }
+            inline double t1() const { return _t0 + _h; }
+            inline double step() const { return _h; }
+
+            /**
+             * @brief The interpolated state, only meaningful for times within the step
+             *
+             * @param time
+             * @return StateArray
+             */
+            StateArray operator()(double time) const;
+    };
+}
+
+#endif
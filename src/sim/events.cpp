@@ -0,0 +1,131 @@
+#include "events.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fmt/core.h>
+#include <stdexcept>
+
+namespace Sim{
+
+    static const int MAX_ROOT_ITERATIONS = 100;
+
+    // whether g has crossed zero in the events direction between ga and gb
+    static bool crossed(int direction, double ga, double gb){
+        bool rising = ga < 0 && gb >= 0;
+        bool falling = ga > 0 && gb <= 0;
+        if(direction > 0){
+            return rising;
+        } else if(direction < 0){
+            return falling;
+        }
+        return rising || falling;
+    }
+
+    EventLocator::EventLocator(double tolerance){
+        _tolerance = tolerance;
+    }
+
+    void EventLocator::add(EventFunction event){
+        _events.push_back(event);
+    }
+
+    void EventLocator::reset(){
+        _fired.fill(false);
+        _records.clear();
+        invalidate();
+    }
+
+    void EventLocator::invalidate(){
+        _samples = {};
+    }
+
+    std::vector<double> EventLocator::evaluate(double time, const StateArray& state) const {
+        for(auto s = _samples.cbegin(); s != _samples.cend(); s++){
+            if(s->time == time && s->g.size() == _events.size()){
+                return s->g;
+            }
+        }
+        std::vector<double> g(_events.size(), NAN_D);
+        for(size_t i = 0; i < _events.size(); i++){
+            if(!_fired[_events[i].id]){
+                g[i] = _events[i].g(time, state);
+            }
+        }
+        return g;
+    }
+
+    std::pair<double, double> EventLocator::findRoot(const EventFunction& event, const DenseOutput& dense, double a, double ga, double b, double gb) const {
+        // illinois regula falsi, falling back to bisection when the secant does not land strictly inside the bracket
+        // which happens for step changes such as burnout where g jumps rather than crossing smoothly
+        int side = 0;
+        for(int i = 0; i < MAX_ROOT_ITERATIONS && b - a > _tolerance; i++){
+            double c = b - gb*(b - a)/(gb - ga);
+            if(!(c > a && c < b)){
+                c = (a + b)/2;
+            }
+            double gc = event.g(c, dense(c));
+            if(crossed(event.direction, ga, gc)){
+                b = c;
+                gb = gc;
+                if(side == -1){
+                    ga /= 2;
+                }
+                side = -1;
+            } else {
+                a = c;
+                ga = gc;
+                if(side == 1){
+                    gb /= 2;
+                }
+                side = 1;
+            }
+        }
+        return { a, b };
+    }
+
+    std::vector<EventRecord> EventLocator::locate(const DenseOutput& dense) const {
+        std::vector<EventRecord> found = {};
+        const double t0 = dense.t0();
+        const double t1 = dense.t1();
+        const StateArray y0 = dense(t0);
+        const StateArray y1 = dense(t1);
+        const std::vector<double> g0 = evaluate(t0, y0);
+        const std::vector<double> g1 = evaluate(t1, y1);
+        for(size_t i = 0; i < _events.size(); i++){
+            const EventFunction& e = _events[i];
+            if(_fired[e.id] || !crossed(e.direction, g0[i], g1[i])){
+                continue;
+            }
+            auto [before, time] = findRoot(e, dense, t0, g0[i], t1, g1[i]);
+            found.push_back({ e.id, time, before, dense(time), e.terminal });
+        }
+        _samples = { Sample{ t0, g0 }, Sample{ t1, g1 } };
+        std::sort(found.begin(), found.end(), [](const EventRecord& l, const EventRecord& r){ return l.time < r.time; });
+        // nothing after a terminal event happens in this step
+        auto firstTerminal = std::find_if(found.begin(), found.end(), [](const EventRecord& r){ return r.terminal; });
+        if(firstTerminal != found.end()){
+            found.erase(firstTerminal + 1, found.end());
+        }
+        return found;
+    }
+
+    void EventLocator::fire(const EventRecord& record){
+        _fired[record.id] = true;
+        _records.push_back(record);
+    }
+
+    void EventLocator::restore(const std::vector<EventRecord>& records){
+        reset();
+        for(auto r = records.cbegin(); r != records.cend(); r++){
+            fire(*r);
+        }
+    }
+
+    const EventRecord& EventLocator::record(Events::FlightEvents id) const {
+        for(auto r = _records.cbegin(); r != _records.cend(); r++){
+            if(r->id == id){
+                return *r;
+            }
+        }
+        throw std::out_of_range(fmt::format("event \"{}\" has not occurred", Events::NAMES[id]));
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef EVENTS_H_
+#define EVENTS_H_
+
+#include "stateArray.hpp"
+#include "denseOutput.hpp"
+#include "nanValues.hpp"
+#include <array>
+#include <cmath>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace Sim{
+
+    namespace Events{
+        // fixed ids of the flight events located during a solve
+        enum FlightEvents {
+            RailExit, Burnout, Apogee, GroundImpact, LAST
+        };
+
+        constexpr std::array<const char*, LAST> NAMES = {
+            "rail exit", "burnout", "apogee", "ground impact"
+        };
+    }
+
+    /**
+     * @brief An event is a zero crossing of g(t, y) in the given direction
+     * each event fires at most once per solve
+     */
+    struct EventFunction{
+        Events::FlightEvents id;
+        std::function<double(double time, const StateArray& state)> g;
+        int direction = 0; // 1 only fires when g rises through zero, -1 when it falls, 0 on either
+        bool terminal = false; // the step is cut short at the event so the dynamics can change there
+    };
+
+    struct EventRecord{
+        Events::FlightEvents id;
+        double time; // the earliest time found at which the event has happened
+        double before; // the latest time found at which it has not, within the locators tolerance of time
+        StateArray state;
+        bool terminal;
+    };
+
+    /**
+     * @brief Locates events within a step by root finding on the step's dense output
+     * so event times do not depend on the step size and steps do not have to shrink around them
+     */
+    class EventLocator{
+        private:
+            std::vector<EventFunction> _events;
+            std::array<bool, Events::LAST> _fired = {};
+            std::vector<EventRecord> _records;
+            double _tolerance;
+
+            // every event's g at a time, one step usually starts where the last ended so its g are reused there
+            struct Sample{
+                double time = NAN_D;
+                std::vector<double> g;
+            };
+            // the start and end of the last step located, a retaken step starts from the same point
+            mutable std::array<Sample, 2> _samples;
+
+            // each event's g at the time and state, from the samples if either is at the same time
+            std::vector<double> evaluate(double time, const StateArray& state) const;
+
+            // narrows the bracket [a, b] around the root of g, returning the final bracket
+            std::pair<double, double> findRoot(const EventFunction& event, const DenseOutput& dense, double a, double ga, double b, double gb) const;
+
+        public:
+            /**
+             * @param tolerance width of the time bracket the root finder stops at in seconds
+             */
+            EventLocator(double tolerance = 1e-9);
+
+            void add(EventFunction event);
+
+            // forgets fired events, called at the start of each solve
+            void reset();
+
+            // forgets the g values kept from the last step, which are reused for a step starting at the same time,
+            // call when the state jumps rather than carrying on from where the last step ended or when anything else the event functions read changes
+            void invalidate();
+
+            /**
+             * @brief Finds the unfired events that occur within the step covered by dense,
+             * sorted by time and stopping at the first terminal event since the step ends there
+             *
+             * @param dense interpolant over the step
+             * @return std::vector<EventRecord>
+             */
+            std::vector<EventRecord> locate(const DenseOutput& dense) const;
+
+            void fire(const EventRecord& record);
+
+            // forgets fired events then fires each of records, for carrying a flight on from a checkpoint
+            void restore(const std::vector<EventRecord>& records);
+
+            inline bool fired(Events::FlightEvents id) const {
+                return _fired[id];
+            }
+
+            // events fired since the last reset, in the order they occurred
+            inline const std::vector<EventRecord>& records() const {
+                return _records;
+            }
+
+            // the record of a fired event, throws if it has not fired
+            const EventRecord& record(Events::FlightEvents id) const;
+    };
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+#include "stateArray.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+namespace Sim{
+
+    /**
+     * @brief Read only view of the most recent steps of a StepHistory, independent of its capacity
+     * entries are counted back from the latest, so diff(1) is the last step taken
+     */
+    class HistoryView{
+        private:
+            const StateArray* _diffs;
+            const double* _steps;
+            size_t _capacity;
+            size_t _head; // where the next step will be written
+            size_t _size;
+
+            inline size_t slot(size_t k) const { return (_head + _capacity - k) % _capacity; }
+
+        public:
+            HistoryView(const StateArray* diffs, const double* steps, size_t capacity, size_t head, size_t size)
+                : _diffs(diffs), _steps(steps), _capacity(capacity), _head(head), _size(size) {}
+
+            // number of steps held, at most the capacity of the history
+            inline size_t size() const { return _size; }
+
+            // the derivative at the start of the kth most recent step, k runs from 1 to size()
+            inline const StateArray& diff(size_t k) const { return _diffs[slot(k)]; }
+            // the size of the kth most recent step
+            inline double step(size_t k) const { return _steps[slot(k)]; }
+    };
+
+    /**
+     * @brief Fixed capacity ring buffer of the last few accepted steps for the multistep integrators
+     * once full each push overwrites the oldest step, so memory is set by the method order rather than the flight length
+     */
+    template<size_t Capacity>
+    class StepHistory{
+        private:
+            std::array<StateArray, Capacity> _diffs;
+            std::array<double, Capacity> _steps;
+            size_t _head = 0;
+            size_t _size = 0;
+
+        public:
+            static constexpr size_t capacity(){ return Capacity; }
+
+            inline void push(double step, const StateArray& diff){
+                _diffs[_head] = diff;
+                _steps[_head] = step;
+                _head = (_head + 1) % Capacity;
+                _size = std::min(_size + 1, Capacity);
+            }
+
+            inline void clear(){
+                _head = 0;
+                _size = 0;
+            }
+
+            inline size_t size() const { return _size; }
+
+            inline HistoryView view() const {
+                return HistoryView(_diffs.data(), _steps.data(), Capacity, _head, _size);
+            }
+    };
+}
+
+#endif
@@ -0,0 +1,131 @@
+#include "massTable.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace Sim{
+
+    static const int BURNOUT_ITERATIONS = 60;
+
+    // linear interpolation between two samples, t is the fraction of the way from a to b
+    static MassProperties lerp(const MassProperties& a, const MassProperties& b, double t){
+        return {
+            a.mass + t*(b.mass - a.mass),
+            a.cm + t*(b.cm - a.cm),
+            a.inertia + t*(b.inertia - a.inertia),
+            a.inverseInertia + t*(b.inverseInertia - a.inverseInertia)
+        };
+    }
+
+    // largest relative error of any quantity of approx against exact, each quantity relative to its own size
+    static double relativeError(const MassProperties& approx, const MassProperties& exact){
+        auto rel = [](double err, double scale){
+            return err/std::max(scale, std::numeric_limits<double>::min());
+        };
+        double err = rel(std::abs(approx.mass - exact.mass), std::abs(exact.mass));
+        err = std::max(err, rel((approx.cm - exact.cm).norm(), exact.cm.norm()));
+        err = std::max(err, rel((approx.inertia - exact.inertia).norm(), exact.inertia.norm()));
+        err = std::max(err, rel((approx.inverseInertia - exact.inverseInertia).norm(), exact.inverseInertia.norm()));
+        return err;
+    }
+
+    static bool burning(RocketInterface* rocket, double time){
+        return rocket->thrust(FlightState(time, 0, 0, 0, 0, 0)).norm() > 0;
+    }
+
+    MassProperties MassTable::evaluate(RocketInterface* rocket, const Eigen::Matrix3d& rotmat, const FlightState& state){
+        MassProperties res;
+        res.mass = rocket->mass(state);
+        res.cm = rotmat*rocket->cm(state);
+        res.inertia = rotmat*rocket->inertia(state)*rotmat.transpose();
+        res.inverseInertia = res.inertia.inverse();
+        return res;
+    }
+
+    MassProperties MassTable::evaluate(const RocketSnapshot& snapshot, const Eigen::Matrix3d& rotmat){
+        MassProperties res;
+        res.mass = snapshot.mass;
+        res.cm = rotmat*snapshot.cm;
+        res.inertia = rotmat*snapshot.inertia*rotmat.transpose();
+        res.inverseInertia = res.inertia.inverse();
+        return res;
+    }
+
+    MassTable::MassTable(RocketInterface* rocket, const Eigen::Matrix3d& rotmat, double tolerance, double scanStep, double maxTime, double minInterval){
+        auto sample = [rocket, &rotmat](double time){
+            return evaluate(rocket, rotmat, FlightState(time, 0, 0, 0, 0, 0));
+        };
+
+        // scanning for burnout, the scan points become the initial grid
+        _times = { 0 };
+        double time = 0;
+        if(burning(rocket, 0)){
+            while(time < maxTime && burning(rocket, std::min(time + scanStep, maxTime))){
+                time = std::min(time + scanStep, maxTime);
+                _times.push_back(time);
+            }
+            // bisecting the last scan interval for the end of the burn
+            double lower = time;
+            double upper = std::min(time + scanStep, maxTime);
+            if(upper > lower){
+                for(int i = 0; i < BURNOUT_ITERATIONS && upper - lower > std::numeric_limits<double>::epsilon()*upper; i++){
+                    double mid = (lower + upper)/2;
+                    if(burning(rocket, mid)){
+                        lower = mid;
+                    } else {
+                        upper = mid;
+                    }
+                }
+                if(lower > _times.back()){
+                    _times.push_back(lower);
+                }
+            }
+            time = upper;
+        }
+        _burnout = time;
+        _afterBurnout = sample(_burnout);
+
+        _samples.reserve(_times.size());
+        for(auto t = _times.cbegin(); t != _times.cend(); t++){
+            _samples.push_back(sample(*t));
+        }
+        // refining from the back so the indices still to be refined don't move
+        for(size_t i = _times.size() - 1; i-- > 0;){
+            refine(rocket, rotmat, tolerance, minInterval, i);
+        }
+    }
+
+    void MassTable::refine(RocketInterface* rocket, const Eigen::Matrix3d& rotmat, double tolerance, double minInterval, size_t index){
+        const double a = _times[index];
+        const double b = _times[index + 1];
+        if(b - a < 2*minInterval){
+            return;
+        }
+        const double mid = (a + b)/2;
+        const MassProperties exact = evaluate(rocket, rotmat, FlightState(mid, 0, 0, 0, 0, 0));
+        if(relativeError(lerp(_samples[index], _samples[index + 1], 0.5), exact) <= tolerance){
+            return;
+        }
+        _times.insert(_times.begin() + index + 1, mid);
+        _samples.insert(_samples.begin() + index + 1, exact);
+        // the upper half first so this intervals index is unchanged
+        refine(rocket, rotmat, tolerance, minInterval, index + 1);
+        refine(rocket, rotmat, tolerance, minInterval, index);
+    }
+
+    MassProperties MassTable::at(double time) const {
+        if(time >= _burnout){
+            return _afterBurnout;
+        }
+        // a burn shorter than the scan's resolution leaves only the sample at ignition
+        if(time <= _times.front() || _times.size() < 2){
+            return _samples.front();
+        }
+        // the last sample is the last time still burning, times between it and burnout use the last interval
+        size_t upper = std::upper_bound(_times.cbegin(), _times.cend(), time) - _times.cbegin();
+        if(upper == _times.size()){
+            upper--;
+        }
+        const size_t lower = upper - 1;
+        return lerp(_samples[lower], _samples[upper], (time - _times[lower])/(_times[upper] - _times[lower]));
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef MASS_TABLE_H_
+#define MASS_TABLE_H_
+
+#include "rocketInterface.hpp"
+#include <vector>
+#include <Eigen/Dense>
+
+namespace Sim{
+
+    /**
+     * @brief Mass properties of the rocket in the sims coordinates, as used by Sim::calculate
+     */
+    struct MassProperties{
+        double mass;
+        Eigen::Vector3d cm;
+        Eigen::Matrix3d inertia;
+        Eigen::Matrix3d inverseInertia;
+    };
+
+    /**
+     * @brief The rockets mass properties sampled over the burn and interpolated between samples
+     * mass properties only change with time while the motor burns, so they are sampled once before a flight
+     * on a time grid refined until linear interpolation reproduces the rocket to within a tolerance, and held constant after burnout
+     */
+    class MassTable{
+        private:
+            std::vector<double> _times;
+            std::vector<MassProperties> _samples;
+            double _burnout; // the table is constant from here on
+            MassProperties _afterBurnout;
+
+            // refines the interval between the samples at index and index + 1 until interpolation meets the tolerance
+            void refine(RocketInterface* rocket, const Eigen::Matrix3d& rotmat, double tolerance, double minInterval, size_t index);
+
+        public:
+            /**
+             * @brief Samples the rocket, the burn is found as the first time the thrust is zero
+             *
+             * @param rocket the rocket to sample
+             * @param rotmat the rotation from the rockets design coords to the sims
+             * @param tolerance allowable relative error of interpolated values at the midpoint of each interval
+             * @param scanStep the step the burn is first searched and sampled at in seconds
+             * @param maxTime the longest burn searched for in seconds, the table is held constant after this if the motor is still burning
+             * @param minInterval the shortest interval refinement will create in seconds
+             */
+            MassTable(RocketInterface* rocket, const Eigen::Matrix3d& rotmat, double tolerance = 1e-6, double scanStep = 0.05, double maxTime = 600, double minInterval = 1e-4);
+
+            /**
+             * @brief Evaluates the rocket directly, rotating its mass properties into the sims coordinates
+             *
+             * @param rocket the rocket to evaluate
+             * @param rotmat the rotation from the rockets design coords to the sims
+             * @param state the flight state to evaluate at
+             * @return MassProperties
+             */
+            static MassProperties evaluate(RocketInterface* rocket, const Eigen::Matrix3d& rotmat, const FlightState& state);
+
+            // as above from a snapshot the rocket has already given
+            static MassProperties evaluate(const RocketSnapshot& snapshot, const Eigen::Matrix3d& rotmat);
+
+            // interpolated mass properties at the given time
+            MassProperties at(double time) const;
+
+            inline double burnout() const { return _burnout; }
+
+            inline size_t size() const { return _times.size(); }
+    };
+}
+
+#endif
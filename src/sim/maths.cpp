@@ -1,5 +1,6 @@
 #include "maths.hpp"
 #include <Eigen/Dense>
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
@@ -31,4 +32,12 @@ namespace Utils{
         return rotmat;
     }
 
+    Eigen::Vector3d rotmatToEuler(const Eigen::Matrix3d& rotmat){
+        // rotmat = Rz(roll)*Ry(pitch)*Rx(yaw), so its bottom row and first column give the angles directly
+        const double pitch = std::asin(std::clamp(-rotmat(2, 0), -1.0, 1.0));
+        const double yaw = std::atan2(rotmat(2, 1), rotmat(2, 2));
+        const double roll = std::atan2(rotmat(1, 0), rotmat(0, 0));
+        return {yaw, pitch, roll};
+    }
+
 }
\ No newline at end of file
@@ -16,4 +16,12 @@ namespace Utils{
      * @return Eigen::Matrix3d 
      */
     Eigen::Matrix3d eulerToRotmat(double yaw, double pitch, double roll);
+
+    /**
+     * @brief the inverse of eulerToRotmat, pitch is within +-pi/2 and yaw and roll within +-pi
+     * 
+     * @param rotmat a rotation matrix
+     * @return Eigen::Vector3d yaw, pitch and roll in radians
+     */
+    Eigen::Vector3d rotmatToEuler(const Eigen::Matrix3d& rotmat);
 }
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "monteCarlo.hpp"
+#include "threadPool.hpp"
+#include "batchSim.hpp"
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+namespace Sim{
+
+    // a run cut off at the step limit never landed so its summary isn't a result
+    static const char STEP_LIMIT_ERROR[] = "the flight reached the step limit before landing";
+
+    MonteCarlo::MonteCarlo(RocketFactory rocketFactory, StateArray nominalConditions, double timeStep, Dispersions dispersions){
+        _rocketFactory = rocketFactory;
+        _nominalConditions = nominalConditions;
+        _timeStep = timeStep;
+        _dispersions = dispersions;
+    }
+
+    std::shared_ptr<MonteCarlo> MonteCarlo::create(RocketFactory rocketFactory, StateArray nominalConditions, double timeStep, Dispersions dispersions){
+        auto obj = std::shared_ptr<MonteCarlo>(
+            new MonteCarlo(rocketFactory, nominalConditions, timeStep, dispersions)
+        );
+        return obj;
+    }
+
+    void MonteCarlo::setIntegrator(IntegrationStrats integrator){
+        if(integrator != RK4 && integrator != AB && integrator != DP45 && integrator != ABM){
+            throw std::invalid_argument("only RK4, AB, DP45 and ABM integration are supported by solve");
+        }
+        _integrator = integrator;
+    }
+
+    void MonteCarlo::configure(Sim& sim) const {
+        sim.setVerbose(false);
+        sim.setSummaryOnly(true);
+        sim.setIntegrator(_integrator);
+        if(_tolerances){
+            sim.setTolerances(_tolerances->first, _tolerances->second);
+        }
+        sim.setAtmosTable(_atmosTable);
+        sim.setKpis(_kpis);
+        sim.setWindProfile(_windProfile);
+        sim.setTurbulenceSettings(_turbulenceSettings);
+    }
+
+    uint64_t MonteCarlo::runSeed(uint64_t seed, size_t index){
+        std::seed_seq seq{ (uint32_t)seed, (uint32_t)(seed >> 32), (uint32_t)index, (uint32_t)(index >> 32) };
+        uint32_t words[2];
+        seq.generate(words, words + 2);
+        return ((uint64_t)words[0] << 32) | words[1];
+    }
+
+    MonteCarlo::DispersedRun MonteCarlo::disperse(uint64_t seed) const {
+        DispersedRun run;
+        std::mt19937_64 rng(seed);
+        std::normal_distribution<double> normal(0.0, 1.0);
+
+        // dispersing initial conditions
+        run.initialConditions = _nominalConditions;
+        for(int i = 0; i < StateMappings::LAST; i++){
+            run.initialConditions[i] += _dispersions.initialConditionSigma[i]*normal(rng);
+        }
+        run.rodLength = std::max(0.0, _rodLength + _dispersions.rodLengthSigma*normal(rng));
+        run.rocket = _rocketFactory(rng);
+        run.simSeed = rng();
+        return run;
+    }
+
+    MonteCarloRun MonteCarlo::runOne(size_t index, uint64_t seed) const {
+        MonteCarloRun res;
+        res.index = index;
+        res.seed = seed;
+        try{
+            DispersedRun run = disperse(seed);
+            res.initialConditions = run.initialConditions;
+
+            auto sim = Sim::create(run.rocket.get(), _timeStep, std::filesystem::path{});
+            configure(*sim);
+            sim->setSeed(run.simSeed);
+            sim->setRodLen(run.rodLength);
+
+            res.finalState = sim->solve(run.initialConditions);
+            res.summary = sim->summary();
+            if(res.summary.stepLimited){
+                res.failed = true;
+                res.error = STEP_LIMIT_ERROR;
+            }
+        } catch(const std::exception& e) {
+            res.failed = true;
+            res.error = e.what();
+        }
+        return res;
+    }
+
+    MonteCarloRun MonteCarlo::runOneFrom(const Checkpoint& checkpoint, size_t index, uint64_t seed) const {
+        MonteCarloRun res;
+        res.index = index;
+        res.seed = seed;
+        res.initialConditions = Sim::externalState(checkpoint);
+        try{
+            std::mt19937_64 rng(seed);
+            auto rocket = _rocketFactory(rng);
+
+            auto sim = Sim::create(rocket.get(), _timeStep, std::filesystem::path{});
+            configure(*sim);
+            sim->setSeed(rng());
+            sim->setRodLen(_rodLength);
+
+            res.finalState = sim->resume(checkpoint, true);
+            res.summary = sim->summary();
+            if(res.summary.stepLimited){
+                res.failed = true;
+                res.error = STEP_LIMIT_ERROR;
+            }
+        } catch(const std::exception& e) {
+            res.failed = true;
+            res.error = e.what();
+        }
+        return res;
+    }
+
+    std::vector<MonteCarloRun> MonteCarlo::runFrom(const Checkpoint& checkpoint, size_t numRuns, uint64_t seed, size_t threads) const {
+        std::vector<MonteCarloRun> results(numRuns);
+        ThreadPool pool(threads);
+        for(size_t i = 0; i < numRuns; i++){
+            pool.submit([this, &checkpoint, &results, i, seed](){
+                results[i] = runOneFrom(checkpoint, i, runSeed(seed, i));
+            });
+        }
+        pool.wait();
+        return results;
+    }
+
+    std::vector<MonteCarloRun> MonteCarlo::run(size_t numRuns, uint64_t seed, size_t threads) const {
+        std::vector<MonteCarloRun> results(numRuns);
+        ThreadPool pool(threads);
+        // one task per run, the pool balances the very different run lengths by stealing
+        for(size_t i = 0; i < numRuns; i++){
+            pool.submit([this, &results, i, seed](){
+                results[i] = runOne(i, runSeed(seed, i));
+            });
+        }
+        pool.wait();
+        return results;
+    }
+
+    template<int Lanes>
+    void MonteCarlo::runBatch(std::vector<MonteCarloRun>& results, size_t first, uint64_t seed) const {
+        const size_t count = std::min<size_t>(Lanes, results.size() - first);
+        std::array<RocketInterface*, Lanes> lanes = {};
+        typename BatchSim<Lanes>::BatchState initialConditions = BatchSim<Lanes>::BatchState::Zero();
+        std::array<DispersedRun, Lanes> runs;
+        try{
+            for(size_t l = 0; l < count; l++){
+                MonteCarloRun& res = results[first + l];
+                res.index = first + l;
+                res.seed = runSeed(seed, first + l);
+                runs[l] = disperse(res.seed);
+                res.initialConditions = runs[l].initialConditions;
+                initialConditions.col(l) = runs[l].initialConditions;
+                lanes[l] = runs[l].rocket.get();
+            }
+
+            auto sim = BatchSim<Lanes>::create(lanes, _timeStep);
+            for(size_t l = 0; l < count; l++){
+                sim->setSeed(l, runs[l].simSeed);
+                sim->setRodLen(l, runs[l].rodLength);
+            }
+            sim->setWindProfile(_windProfile);
+            sim->setTurbulenceSettings(_turbulenceSettings);
+            sim->setAtmosTable(_atmosTable);
+            sim->setKpis(_kpis);
+            auto finalStates = sim->solve(initialConditions);
+            for(size_t l = 0; l < count; l++){
+                results[first + l].finalState = finalStates.col(l);
+                results[first + l].summary = sim->summary(l);
+                if(results[first + l].summary.stepLimited){
+                    results[first + l].failed = true;
+                    results[first + l].error = STEP_LIMIT_ERROR;
+                }
+            }
+        } catch(const std::exception& e) {
+            for(size_t l = 0; l < count; l++){
+                results[first + l].failed = true;
+                results[first + l].error = e.what();
+            }
+        }
+    }
+
+    std::vector<MonteCarloRun> MonteCarlo::runBatched(size_t numRuns, uint64_t seed, size_t threads) const {
+        std::vector<MonteCarloRun> results(numRuns);
+        ThreadPool pool(threads);
+        for(size_t first = 0; first < numRuns; first += BATCH_LANES){
+            pool.submit([this, &results, first, seed](){
+                runBatch<BATCH_LANES>(results, first, seed);
+            });
+        }
+        pool.wait();
+        return results;
+    }
+}
@@ -0,0 +1,189 @@
+#ifndef MONTE_CARLO_H_
+#define MONTE_CARLO_H_
+
+#include "simulation.hpp"
+#include "rocketInterface.hpp"
+#include "stateArray.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace Sim{
+
+    /**
+     * @brief 1 sigma normal dispersions applied to each run on top of the nominal values
+     */
+    struct Dispersions{
+        StateArray initialConditionSigma = StateArray::Zero();
+        double rodLengthSigma = 0;
+    };
+
+    /**
+     * @brief Result of a single dispersed flight
+     */
+    struct MonteCarloRun{
+        size_t index = 0;
+        uint64_t seed = 0;
+        StateArray initialConditions = StateArray::Zero(); // for runs forked by runFrom, the checkpoints state with euler angles
+        StateArray finalState = StateArray::Zero();
+        FlightSummary summary;
+        bool failed = false;
+        std::string error;
+    };
+
+    class MonteCarlo{
+        public:
+            /**
+             * @brief Creates a rocket for a single run, it is called once per run so every run flies its own instance
+             * the generator is seeded for the run so rocket dispersions can be drawn from it reproducibly
+             */
+            using RocketFactory = std::function<std::shared_ptr<RocketInterface>(std::mt19937_64& rng)>;
+
+        private:
+            RocketFactory _rocketFactory;
+            StateArray _nominalConditions;
+            double _timeStep;
+            double _rodLength = 0.1;
+            Dispersions _dispersions;
+            std::shared_ptr<const WindProfile> _windProfile = nullptr;
+            TurbulenceSettings _turbulenceSettings;
+            // settings handed to each runs sim, left at the sims defaults when unset
+            IntegrationStrats _integrator = RK4;
+            std::optional<std::pair<StateArray, StateArray>> _tolerances; // rtol then atol
+            std::shared_ptr<const RealAtmos::AtmosTable> _atmosTable = nullptr;
+            Kpis::KpiMask _kpis = Kpis::allKpis();
+
+            MonteCarlo(RocketFactory rocketFactory, StateArray nominalConditions, double timeStep, Dispersions dispersions);
+
+            // everything drawn for a single run before it is flown
+            struct DispersedRun{
+                StateArray initialConditions;
+                double rodLength;
+                std::shared_ptr<RocketInterface> rocket;
+                uint64_t simSeed;
+            };
+
+            DispersedRun disperse(uint64_t seed) const;
+            // applies the settings shared by every run to a runs sim
+            void configure(Sim& sim) const;
+            MonteCarloRun runOne(size_t index, uint64_t seed) const;
+            MonteCarloRun runOneFrom(const Checkpoint& checkpoint, size_t index, uint64_t seed) const;
+            template<int Lanes>
+            void runBatch(std::vector<MonteCarloRun>& results, size_t first, uint64_t seed) const;
+
+        public:
+            static std::shared_ptr<MonteCarlo> create(
+                RocketFactory rocketFactory, StateArray nominalConditions, double timeStep, Dispersions dispersions = Dispersions{}
+                );
+
+            inline const Dispersions& dispersions() const {
+                return _dispersions;
+            }
+
+            inline void setDispersions(Dispersions dispersions){
+                _dispersions = dispersions;
+            }
+
+            inline std::shared_ptr<const WindProfile> windProfile() const {
+                return _windProfile;
+            }
+
+            // the mean wind every run flies through, nullptr for still air
+            inline void setWindProfile(std::shared_ptr<const WindProfile> profile){
+                _windProfile = profile;
+            }
+
+            inline const TurbulenceSettings& turbulenceSettings() const {
+                return _turbulenceSettings;
+            }
+
+            // every run draws its own gusts from its seed
+            inline void setTurbulenceSettings(TurbulenceSettings settings){
+                _turbulenceSettings = settings;
+            }
+
+            inline const double rodLength() const {
+                return _rodLength;
+            }
+
+            inline void setRodLength(double rodLength){
+                _rodLength = rodLength;
+            }
+
+            inline const IntegrationStrats integrator() const {
+                return _integrator;
+            }
+
+            // the integrator run flies with, throws std::invalid_argument for integrators Sim::solve does not support,
+            // runFrom flies the checkpoints integrator and runBatched always flies RK4 as BatchSim does
+            void setIntegrator(IntegrationStrats integrator);
+
+            // tolerances of the adaptive integrators, as in Sim::setTolerances
+            inline void setTolerances(const StateArray& rtol, const StateArray& atol){
+                _tolerances = {rtol, atol};
+            }
+
+            // shared by every run, read only so it is safe across the pool
+            inline void setAtmosTable(std::shared_ptr<const RealAtmos::AtmosTable> table){
+                _atmosTable = table;
+            }
+
+            // kpis tracked in each run, as in Sim::setKpis
+            inline void setKpis(Kpis::KpiMask kpis){
+                _kpis = kpis;
+            }
+
+            /**
+             * @brief Seed used for a single run, depends only on the base seed and run index so results do not depend on scheduling
+             */
+            static uint64_t runSeed(uint64_t seed, size_t index);
+
+            /**
+             * @brief Flies numRuns dispersed flights across a work stealing pool, runs that throw are marked as failed
+             *
+             * @param numRuns number of flights
+             * @param seed base seed for the whole set
+             * @param threads number of worker threads, 0 uses every core
+             * @return std::vector<MonteCarloRun> the runs in index order
+             */
+            std::vector<MonteCarloRun> run(size_t numRuns, uint64_t seed = 69, size_t threads = 0) const;
+
+            /**
+             * @brief Forks numRuns flights from one checkpoint so a shared first phase is flown once rather than once per run,
+             * each run flies its own rocket from the factory and draws from its own generator after the checkpoint,
+             * the initial condition and rod length dispersions don't apply as the flights start part way through
+             *
+             * @param checkpoint where every run starts, taken with Sim::setCheckpointTime or Sim::setCheckpointEvent
+             * @param numRuns number of flights
+             * @param seed base seed for the whole set
+             * @param threads number of worker threads, 0 uses every core
+             * @return std::vector<MonteCarloRun> the runs in index order
+             */
+            std::vector<MonteCarloRun> runFrom(const Checkpoint& checkpoint, size_t numRuns, uint64_t seed = 69, size_t threads = 0) const;
+
+            // number of runs flown together by runBatched, fixed rather than matched to the build's vector width
+            // so a run's results don't depend on the flags it was compiled with
+            static const int BATCH_LANES = 4;
+
+            /**
+             * @brief As run, but each task flies BATCH_LANES runs in lockstep with a BatchSim
+             * runs are dispersed and stepped as run flies them, each lane independently of the others in its batch,
+             * so results only differ from run's by rounding,
+             * the wind profile, turbulence, atmosphere table and kpis apply as they do to run, each run drawing its own gusts,
+             * but every lane flies RK4 whatever integrator is set,
+             * if any run in a batch throws the whole batch is marked as failed
+             *
+             * @param numRuns number of flights
+             * @param seed base seed for the whole set
+             * @param threads number of worker threads, 0 uses every core
+             * @return std::vector<MonteCarloRun> the runs in index order
+             */
+            std::vector<MonteCarloRun> runBatched(size_t numRuns, uint64_t seed = 69, size_t threads = 0) const;
+    };
+}
+
+#endif
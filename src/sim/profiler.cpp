@@ -0,0 +1,111 @@
+#include "profiler.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <fmt/core.h>
+
+namespace Sim{
+
+    const char* Profiler::phaseName(Phase phase){
+        switch(phase){
+            case Step: return "step";
+            case AcceptedStep: return "accepted step";
+            case RejectedStep: return "rejected step";
+            case Calculate: return "calculate";
+            case Atmosphere: return "atmosphere";
+            case Aero: return "aero";
+            case MassProperties: return "mass properties";
+            case Events: return "events";
+            case Output: return "output";
+            default: return "unknown";
+        }
+    }
+
+    // the power of two below ns picks the octave and the next two bits the bucket within it
+    int Profiler::Histogram::bucket(int64_t ns){
+        const uint64_t n = static_cast<uint64_t>(std::max<int64_t>(ns, 1));
+        const int octave = std::bit_width(n) - 1;
+        const uint64_t sub = octave >= 2 ? (n >> (octave - 2)) & 3 : (n << (2 - octave)) & 3;
+        return std::min(octave*SUB_BUCKETS + static_cast<int>(sub), SUB_BUCKETS*OCTAVES - 1);
+    }
+
+    double Profiler::Histogram::bucketMid(int index){
+        const int octave = index/SUB_BUCKETS;
+        const int sub = index % SUB_BUCKETS;
+        const double width = std::ldexp(1.0, octave)/SUB_BUCKETS;
+        return std::ldexp(1.0, octave) + (sub + 0.5)*width;
+    }
+
+    void Profiler::Histogram::record(int64_t ns){
+        _buckets[bucket(ns)]++;
+        _count++;
+        _total += ns;
+        _min = std::min(_min, ns);
+        _max = std::max(_max, ns);
+    }
+
+    void Profiler::Histogram::merge(const Histogram& other){
+        for(size_t i = 0; i < _buckets.size(); i++){
+            _buckets[i] += other._buckets[i];
+        }
+        _count += other._count;
+        _total += other._total;
+        _min = std::min(_min, other._min);
+        _max = std::max(_max, other._max);
+    }
+
+    double Profiler::Histogram::percentile(double p) const {
+        if(_count == 0){
+            return 0;
+        }
+        const double target = p*_count;
+        uint64_t seen = 0;
+        for(size_t i = 0; i < _buckets.size(); i++){
+            seen += _buckets[i];
+            if(seen >= target && _buckets[i] > 0){
+                // the bucket middle can fall outside the recorded range for the first and last buckets
+                return std::clamp(bucketMid(i), static_cast<double>(_min), static_cast<double>(_max));
+            }
+        }
+        return _max;
+    }
+
+    void Profiler::merge(const Profiler& other){
+        for(int i = 0; i < NUM_PHASES; i++){
+            _phases[i].merge(other._phases[i]);
+        }
+    }
+
+    void Profiler::reset(){
+        _phases.fill(Histogram{});
+    }
+
+    double Profiler::calculatesPerStep() const {
+        const uint64_t steps = _phases[Step].count();
+        return steps > 0 ? static_cast<double>(_phases[Calculate].count())/steps : 0;
+    }
+
+    std::string Profiler::report() const {
+        std::string out = fmt::format(
+            "{:<16} {:>10} {:>12} {:>10} {:>10} {:>10} {:>10}\n",
+            "phase", "calls", "total ms", "mean ns", "p50 ns", "p99 ns", "max ns"
+            );
+        for(int i = 0; i < NUM_PHASES; i++){
+            const Histogram& h = _phases[i];
+            if(h.count() == 0){
+                continue;
+            }
+            out += fmt::format(
+                "{:<16} {:>10} {:>12.3f} {:>10.0f} {:>10.0f} {:>10.0f} {:>10}\n",
+                phaseName(static_cast<Phase>(i)), h.count(), h.total()/1e6, h.mean(), h.percentile(0.5), h.percentile(0.99), h.max()
+                );
+        }
+        const uint64_t attempts = _phases[AcceptedStep].count() + _phases[RejectedStep].count();
+        out += fmt::format("{:.2f} calculate calls per step", calculatesPerStep());
+        if(attempts > 0){
+            out += fmt::format(", {:.1f}% of step attempts rejected", 100.0*_phases[RejectedStep].count()/attempts);
+        }
+        out += "\n";
+        return out;
+    }
+}
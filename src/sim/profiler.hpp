@@ -0,0 +1,131 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace Sim{
+
+    /**
+     * @brief Per phase call counts and latency histograms for the sims hot path
+     * the sim is only instrumented when built with FARSEER_PROFILE defined, otherwise the macros below compile to nothing
+     * and the profiler stays empty
+     */
+    class Profiler{
+        public:
+            enum Phase{
+                Step, // one pass of the solve loop, an accepted step along with its events and output
+                AcceptedStep, // an integrator attempt that was accepted
+                RejectedStep, // an integrator attempt that was rejected and retaken
+                Calculate, // one derivative evaluation
+                Atmosphere,
+                Aero, // the rockets evaluate call, the aero coefficients and everything else the rocket gives
+                MassProperties,
+                Events,
+                Output,
+                NUM_PHASES
+            };
+
+            static const char* phaseName(Phase phase);
+
+            using clock = std::chrono::steady_clock;
+
+            /**
+             * @brief Log spaced latency histogram, four buckets per power of two so percentiles are within about 10%
+             */
+            class Histogram{
+                private:
+                    static const int SUB_BUCKETS = 4;
+                    static const int OCTAVES = 48;
+                    std::array<uint64_t, SUB_BUCKETS*OCTAVES> _buckets = {};
+                    uint64_t _count = 0;
+                    double _total = 0;
+                    int64_t _min = INT64_MAX;
+                    int64_t _max = 0;
+
+                    static int bucket(int64_t ns);
+                    static double bucketMid(int index);
+
+                public:
+                    void record(int64_t ns);
+                    void merge(const Histogram& other);
+
+                    inline uint64_t count() const { return _count; }
+                    inline double total() const { return _total; }
+                    inline double mean() const { return _count > 0 ? _total/_count : 0; }
+                    inline int64_t min() const { return _count > 0 ? _min : 0; }
+                    inline int64_t max() const { return _max; }
+
+                    // the latency below which fraction p of the calls fall, in nanoseconds
+                    double percentile(double p) const;
+            };
+
+            /**
+             * @brief Records the time from its construction to its destruction against a phase
+             */
+            class Scope{
+                private:
+                    Profiler& _profiler;
+                    Phase _phase;
+                    clock::time_point _start;
+
+                public:
+                    Scope(Profiler& profiler, Phase phase) : _profiler(profiler), _phase(phase), _start(clock::now()) {}
+                    ~Scope(){ _profiler.record(_phase, _start); }
+
+                    Scope(const Scope&) = delete;
+                    void operator=(const Scope&) = delete;
+            };
+
+        private:
+            std::array<Histogram, NUM_PHASES> _phases;
+
+        public:
+            static inline clock::time_point now(){ return clock::now(); }
+
+            inline void record(Phase phase, int64_t ns){
+                _phases[phase].record(ns);
+            }
+
+            inline void record(Phase phase, clock::time_point start){
+                record(phase, std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+            }
+
+            inline const Histogram& phase(Phase phase) const {
+                return _phases[phase];
+            }
+
+            // adds another profilers results to this one, for combining the sims of a monte carlo set
+            void merge(const Profiler& other);
+
+            void reset();
+
+            // derivative evaluations per step of the solve loop
+            double calculatesPerStep() const;
+
+            /**
+             * @brief A table of every phase that was entered with its call count, total time and mean, p50, p99 and max latency
+             *
+             * @return std::string
+             */
+            std::string report() const;
+    };
+}
+
+#ifdef FARSEER_PROFILE
+#define FARSEER_PROFILE_CONCAT_(a, b) a##b
+#define FARSEER_PROFILE_CONCAT(a, b) FARSEER_PROFILE_CONCAT_(a, b)
+// times the rest of the enclosing scope against a phase
+#define FARSEER_PROFILE_SCOPE(profiler, phase) ::Sim::Profiler::Scope FARSEER_PROFILE_CONCAT(profileScope_, __LINE__)(profiler, ::Sim::Profiler::phase)
+// starts a timer to be recorded by FARSEER_PROFILE_RECORD, for regions whose phase is only known at the end
+#define FARSEER_PROFILE_START(name) const auto name = ::Sim::Profiler::now()
+#define FARSEER_PROFILE_RECORD(profiler, phase, name) (profiler).record(::Sim::Profiler::phase, name)
+#else
+#define FARSEER_PROFILE_SCOPE(profiler, phase)
+#define FARSEER_PROFILE_START(name)
+#define FARSEER_PROFILE_RECORD(profiler, phase, name)
+#endif
+
+#endif
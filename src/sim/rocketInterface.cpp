@@ -0,0 +1,24 @@
+#include "rocketInterface.hpp"
+
+namespace Sim{
+
+    RocketSnapshot RocketInterface::evaluate(const FlightState& state, bool massProperties){
+        RocketSnapshot res;
+        if(massProperties){
+            res.mass = mass(state);
+            res.cm = cm(state);
+            res.inertia = inertia(state);
+        }
+        res.thrust = thrust(state);
+        res.referenceArea = referenceArea(state);
+        res.referenceLength = referenceLength(state);
+        res.c_n = c_n(state);
+        res.cp = cp(state);
+        res.c_m_damp_pitch = c_m_damp_pitch(state);
+        res.c_m_damp_yaw = c_m_damp_yaw(state);
+        res.Cdf = Cdf(state);
+        res.Cdp = Cdp(state);
+        res.Cdb = Cdb(state);
+        return res;
+    }
+}
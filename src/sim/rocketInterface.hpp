@@ -1,6 +1,8 @@
 # ifndef ROCKET_INTERFACE_H_
 # define ROCKET_INTERFACE_H_
 
+#include "nanValues.hpp"
+#include <cmath>
 #include <vector>
 #include <Eigen/Dense>
 
@@ -38,6 +40,31 @@ namespace Sim{
             _reL(reL),
             _gamma(gamma)
             {}
+
+            bool operator==(const FlightState& other) const = default;
+    };
+
+    /**
+     * Every quantity the sim needs from a rocket at one flight state, in the rockets design coordinates
+     * the mass properties may be left NaN when they were not asked for, thrustPosition and c_m are not used by the sim so
+     * RocketInterface::evaluate leaves them NaN as well
+     */
+    struct RocketSnapshot{
+        double mass = NAN_D;
+        Eigen::Vector3d cm = NAN_V3D;
+        Eigen::Matrix3d inertia = NAN_M3D;
+        Eigen::Vector3d thrust;
+        Eigen::Vector3d thrustPosition = NAN_V3D;
+        double referenceArea;
+        double referenceLength;
+        double c_n;
+        double c_m = NAN_D;
+        Eigen::Vector3d cp;
+        double c_m_damp_pitch;
+        double c_m_damp_yaw;
+        double Cdf;
+        double Cdp;
+        double Cdb;
     };
 
     class RocketInterface{
@@ -193,6 +220,16 @@ namespace Sim{
              */
             //virtual double Cdb(const double mach, const double time, const double alpha) = 0;
             virtual double Cdb(const FlightState& state) = 0;
+
+            /**
+             * @brief Every quantity at once, this is what the sim calls on each derivative evaluation
+             * the default calls each function the sim uses in turn, override it to share work between them
+             * 
+             * @param state 
+             * @param massProperties whether mass, cm and inertia are needed, the sim skips them when it has tabulated them
+             * @return RocketSnapshot 
+             */
+            virtual RocketSnapshot evaluate(const FlightState& state, bool massProperties);
     };
 }
 
@@ -1,13 +1,19 @@
 #include "simulation.hpp"
 #include "RealAtmos.hpp"
 #include "maths.hpp"
+#include "trajectoryWriter.hpp"
+#include "denseOutput.hpp"
 #include <cstdlib>
 #include <iostream>
-#include <fstream>
 #include <fmt/core.h>
 #include <chrono>
 #include <cassert>
 #include <cmath>
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <sstream>
+#include <tuple>
 
 namespace Sim{
 
@@ -17,7 +23,7 @@ namespace Sim{
         return ss.str();
     }
 
-    const std::tuple<StateArray, StepData> Sim::defK1arg = {defaultStateVector()*NAN_D, {}};
+    const std::tuple<StateArray, StepData> Sim::defK1arg = {defaultStateVector()*NAN_D, StepData::Zero()};
 
     Sim::Sim(RocketInterface* rocket, double timeStep, std::filesystem::path destination){
         saveFile = destination;
@@ -25,33 +31,37 @@ namespace Sim{
         _rocket = rocket;
         _rodLen = 0.1;
         _atmos = RealAtmos::RealAtmos::GetInstance();
+        _rotmat = alignmentRotation(rocket->thisWayUp(), thisWayUp());
+    }
+
+    Eigen::Matrix3d Sim::alignmentRotation(Eigen::Vector3d rocketUp, Eigen::Vector3d thisUp){
+        Eigen::Matrix3d rotmat;
         // https://math.stackexchange.com/questions/180418/calculate-rotation-matrix-to-align-vector-a-to-vector-b-in-3d
-        auto thisUp = thisWayUp();
-        auto rocketUp = rocket->thisWayUp();
         // setting rotation matrix
         // the maths in the else block doesn't apply if the vectors are either the same or opposite
         if(thisUp == -rocketUp){
             // cannot use cross product with rocket vec as it returns [0,0,0]
-            //_rotmat = Eigen::AngleAxisd(M_PI, thisUp.cross(rocketUp));
+            //rotmat = Eigen::AngleAxisd(M_PI, thisUp.cross(rocketUp));
             // use cross product with this vector and some other arbitraty vector
             // need 2 candicates just in case the arbitrary addition is parallel
             if(thisUp.normalized() != Eigen::Vector3d{1,1,1}.normalized()){
-                _rotmat = Eigen::AngleAxisd(M_PI, thisUp.cross(thisUp + Eigen::Vector3d{1,1,1}));
+                rotmat = Eigen::AngleAxisd(M_PI, thisUp.cross(thisUp + Eigen::Vector3d{1,1,1}));
             } else {
                 // something parallel with [1,1,1] cant be parallel with [1,2,3]
-                _rotmat = Eigen::AngleAxisd(M_PI, thisUp.cross(thisUp + Eigen::Vector3d{1,2,3}));
+                rotmat = Eigen::AngleAxisd(M_PI, thisUp.cross(thisUp + Eigen::Vector3d{1,2,3}));
             }
         } else if(thisUp == rocketUp){
-            _rotmat = Eigen::Matrix3d::Identity();
+            rotmat = Eigen::Matrix3d::Identity();
         } else {
             auto ang = std::acos( thisUp.dot(rocketUp)/(thisUp.norm()*rocketUp.norm()) );
             auto v = rocketUp.cross(thisUp);
             auto s = v.norm()*std::sin(ang);
             auto c = rocketUp.dot(thisUp)*std::cos(ang);
             Eigen::Matrix3d vx = v.asSkewSymmetric();
-            _rotmat = Eigen::Matrix3d::Identity() + vx + (vx*vx)*(1-c)/std::pow(s,2);
+            rotmat = Eigen::Matrix3d::Identity() + vx + (vx*vx)*(1-c)/std::pow(s,2);
         }
-        assert( _rotmat*rocketUp == thisUp );
+        assert( rotmat*rocketUp == thisUp );
+        return rotmat;
     }
 
     std::shared_ptr<Sim> Sim::create(RocketInterface* rocket, double timeStep, std::filesystem::path destination){
@@ -68,77 +78,202 @@ namespace Sim{
     StateArray Sim::solve( StateArray initialConditions ){
         _takeoff = false;
         _onRod = true;
-        std::vector<StateArray> states = { initialConditions };
-        std::vector<StateArray> diffs = {};
-        std::vector<double> steps = {};
-        std::vector<StepData> stepData = { std::get<1>(calculate(0, initialConditions)) };
-        stepData[0]["t"] = 0; stepData[0]["ctime"] = 0;
+        _lastError = 1e-4;
+        _lastRejected = false;
+        _abmRestart = true;
+        _profiler.reset();
+        _history.clear();
+        _checkpoint.reset();
+        // the rocket may have changed since the last solve so the table is always rebuilt
+        _massTable = _tabulateMass ? std::make_shared<const MassTable>(_rocket, _rotmat) : nullptr;
+        // the gusts get their own stream so turning them on doesn't change the other random draws
+        _turbulence = _turbulenceSettings.enabled() ? Turbulence::generate(_turbulenceSettings, _seed ^ TURBULENCE_SEED_SALT) : nullptr;
+
+        StateArray state = internalState(initialConditions);
+
+        _rng.seed( _seed );
+        setRodVec(Utils::eulerToRotmat(initialConditions[Phi], initialConditions[Theta], initialConditions[Psi])*thisWayUp());
+        resetEvents();
+
+        Checkpoint start;
+        start.state = state;
+        start.step = userStep();
+        start.apogee = initialConditions[Zp];
+        // the derivative at the end of each step is needed for its interpolant and is reused as the first stage of the next step,
+        // so the one at the start is also what is written out for the first row
+        std::tie(start.derivative, start.derivativeData) = calculate(0, state);
+        StepData initialData = start.derivativeData;
+        initialData[Telemetry::Time] = 0; initialData[Telemetry::CompTime] = 0;
+        // kpis are kept as the flight goes so nothing has to be stored to find them afterwards
+        if(_kpis.test(Kpis::MaxMach)){
+            start.maxMach = initialData[Telemetry::Mach];
+        }
+        if(_kpis.test(Kpis::MaxDynamicPressure)){
+            start.maxDynamicPressure = initialData[Telemetry::DynamicPressure];
+        }
+        return fly(start, initialConditions, initialData);
+    }
+
+    StateArray Sim::resume( const Checkpoint& checkpoint, bool reseed ){
+        _profiler.reset();
+        _checkpoint.reset();
+        // the rocket may differ from the one the checkpoint was taken with, the table is built first as the events use it
+        _massTable = _tabulateMass ? std::make_shared<const MassTable>(_rocket, _rotmat) : nullptr;
+        restoreSolverState(checkpoint);
+        if(reseed){
+            _rng.seed( _seed );
+        }
+        const auto gustSeed = reseed ? _seed : checkpoint.seed;
+        _turbulence = _turbulenceSettings.enabled() ? Turbulence::generate(_turbulenceSettings, gustSeed ^ TURBULENCE_SEED_SALT) : nullptr;
+
+        Checkpoint start = checkpoint;
+        // the stored derivative holds the forces and random draws of the flight that took the checkpoint,
+        // so a fork starts from its own as a fresh flight from the same state would
+        const bool exact = !reseed && (checkpoint.rocket == nullptr || checkpoint.rocket == _rocket);
+        if(!exact){
+            std::tie(start.derivative, start.derivativeData) = calculate(checkpoint.time, checkpoint.state);
+            // the integrator memory was built from the old derivatives too
+            _abmRestart = true;
+            _history.clear();
+        }
+        StepData firstData = start.derivativeData;
+        firstData[Telemetry::Time] = checkpoint.time; firstData[Telemetry::CompTime] = 0;
+        return fly(start, externalState(checkpoint.state), firstData);
+    }
 
+    StateArray Sim::fly( const Checkpoint& start, const StateArray& firstState, const StepData& firstData ){
         std::chrono::high_resolution_clock clock;
-        std::srand( 69 );
-        StateArray lastState = initialConditions;
-        StateArray state = initialConditions;
+        // steps are streamed out as they are accepted rather than stored
+        std::unique_ptr<TrajectoryWriter> writer = nullptr;
+        auto fname = outFile();
+        if(!fname.empty() && !summaryOnly()){
+            if(verbose()) fmt::print("writing results to file \"{}\"\n", fname.string());
+            writer = std::make_unique<TrajectoryWriter>(fname, channels(), _attitudeRepresentation == QUATERNION);
+            writer->push(firstState, firstData);
+        }
+        _trajectory = Trajectory(channels());
+        const bool record = recordTrajectory() && !summaryOnly();
+        if(record){
+            _trajectory.push(firstState, firstData);
+        }
+        double apogee = start.apogee;
+        double apogeeTime = start.apogeeTime;
+        FlightSummary kpis;
+        kpis.maxMach = start.maxMach;
+        kpis.maxDynamicPressure = start.maxDynamicPressure;
+        kpis.railExitVelocity = start.railExitVelocity;
+        kpis.landingPosition = start.landingPosition;
+        int64_t totalTime = start.compTime;
+        StateArray state = start.state;
         StateArray newState;
 
-        setRodVec(Utils::eulerToRotmat(initialConditions[Phi], initialConditions[Theta], initialConditions[Psi])*thisWayUp());
-
-        const int maxSteps = 1e5;
-        int counter = 0;
-        double step = userStep();
-        double time = 0;
+        int counter = start.counter;
+        double step = start.step;
+        double time = start.time;
         bool term = false;
+        bool stepLimited = false;
+        std::tuple<StateArray, StepData> k1Dat = { start.derivative, start.derivativeData };
         // start timer
-        fmt::print("starting sim\n");
+        if(verbose()) fmt::print("starting sim\n");
         // loop will not terminate until a termination event is reached
         auto lastCalc = clock.now();
         while(!term){
+            FARSEER_PROFILE_SCOPE(_profiler, Step);
             // doing calc
-            std::tuple<double, StateArray, StepData> timeAndState;
-            //timeAndState = eulerIntegrate(time, step, &state, &lastState);
-            //timeAndState = ABRKIntegrate(time, step, &state, &lastState, &diffs, &stepData, &steps);
-            timeAndState = ORKIntegrate(time, step, &state, &lastState);
-            //timeAndState = adaptiveRKIntegrate(time, step, state);
-
-            //timeAndState = RK4Integrate(time, step, state, lastState);
-
-            newState = std::get<1>(timeAndState);
-            auto thisStep = std::get<0>(timeAndState) - time;
+            StepResult res;
+            if(integrator() == DP45){
+                res = DP45Integrate(time, step, &state, &k1Dat);
+            } else if(integrator() == ABM){
+                res = ABMIntegrate(time, step, &state, &k1Dat);
+            } else if(integrator() == AB){
+                StateArray k1 = std::get<0>(k1Dat);
+                FARSEER_PROFILE_START(attempt);
+                res = ABRKIntegrate(time, selectTimeStep(&state, &k1, step), &state, &k1Dat, _history.view());
+                FARSEER_PROFILE_RECORD(_profiler, AcceptedStep, attempt);
+            } else {
+                StateArray k1 = std::get<0>(k1Dat);
+                FARSEER_PROFILE_START(attempt);
+                res = takeStep(time, selectTimeStep(&state, &k1, step), &state, &k1Dat);
+                FARSEER_PROFILE_RECORD(_profiler, AcceptedStep, attempt);
+            }
+            step = res.nextStep;
+
+            // a terminal event ends the step early, the step is retaken up to just before the event so the state there is as accurate as any other step
+            // and the next step starts just after it so none of its stages see the conditions from before the event
+            FARSEER_PROFILE_START(eventsStart);
+            auto stepEvents = _events.locate(res.dense);
+            FARSEER_PROFILE_RECORD(_profiler, Events, eventsStart);
+            bool truncated = !stepEvents.empty() && stepEvents.back().terminal;
+            if(truncated){
+                res = takeStep(time, stepEvents.back().before - time, &state, &k1Dat);
+                res.time = stepEvents.back().time;
+                stepEvents.back().state = res.state;
+            }
+            const double newTime = res.time;
+            newState = res.state;
+            StepData stepDat = res.data;
+            auto thisStep = newTime - time;
 
-            StateArray diff = (newState-state)/thisStep;
-            step = thisStep;
+            if(usesHistory() && thisStep > 0){
+                _history.push(thisStep, std::get<0>(k1Dat));
+            }
             newState = (std::numeric_limits<double>::epsilon() < newState.abs()).select(newState, 0);
 
+            const bool wasTakeoff = takeoff();
+            const bool wasOnRod = onRod();
             // adjusting for takeoff
             if(!takeoff()){
                 if(newState[Zv] > 0){
                     setTakeoff(true);
                 }
             }
-            // adjusting for rod
-            if(onRod()){
-                if( stateArrayPosition(newState).norm() > rodLen()){
-                    setOnRod(false);
-                    fmt::print("off rod at step {}\n", counter);
+
+            for(auto e = stepEvents.begin(); e != stepEvents.end(); e++){
+                _events.fire(*e);
+                switch(e->id){
+                    case Events::RailExit:
+                        // adjusting for rod
+                        setOnRod(false);
+                        if(_kpis.test(Kpis::RailExitVelocity)){
+                            kpis.railExitVelocity = stateArrayVelocity(e->state).norm();
+                        }
+                        if(verbose()) fmt::print("off rod at step {}, t = {:.6f}\n", counter, e->time);
+                        break;
+                    case Events::GroundImpact:
+                        // terminating on landing
+                        term = true;
+                        if(_kpis.test(Kpis::LandingPosition)){
+                            kpis.landingPosition = stateArrayPosition(e->state);
+                        }
+                        break;
+                    default:
+                        break;
                 }
             }
-
-            // checking termination events
-            // terminating on landing
-            if( newState[Zp] < 0 && state[Zp] >= 0 && _takeoff){
-                // rocket has passed 0 negatively
+            // terminating on max steps, the flight is marked as unfinished so it isn't mistaken for one that landed
+            if( !term && counter >= MAX_STEPS ){
                 term = true;
+                stepLimited = true;
             }
-            // terminating on max steps
-            if( counter >= maxSteps ){
-                term = true;
+            const bool rebased = rebaseAttitude(newState);
+
+            // the end derivative was found with the old flags and at the untruncated and unrebased state so it can't always be reused
+            if(truncated || rebased || wasTakeoff != takeoff() || wasOnRod != onRod()){
+                // the event functions read the flags too, so what they gave at the end of the step can't be reused either
+                _events.invalidate();
+                k1Dat = calculate(newTime, newState);
+                // the adams history spans the discontinuity so it has to be rebuilt
+                _abmRestart = true;
+                _history.clear();
+            } else {
+                k1Dat = res.endDat;
             }
 
             // incrementing time
             counter++;
-            time += thisStep;
+            time = newTime;
 
             // reallocating arrays
-            lastState = state;
             state = newState;
             // store timer val
             auto thisCalc = clock.now();
@@ -147,67 +282,212 @@ namespace Sim{
             lastCalc = thisCalc;
 
             // storing data
-            auto stepDat = std::get<2>(timeAndState);
-            stepDat["t"] = time;
-            stepDat["ctime"] = cTime;
+            stepDat[Telemetry::Time] = time;
+            stepDat[Telemetry::CompTime] = cTime;
+            totalTime += cTime;
 
-            steps.push_back(thisStep);
-            states.push_back(newState);
-            diffs.push_back(diff);
-            stepData.push_back(stepDat);
-        }
-        
-        // getting apogee to print
-        double apogee = 0;
-        double apogeeTime = 0;
-        for(long long unsigned int i = 0; i < states.size(); i++){
-            StateArray st = states[i];
-            StepData dat = stepData[i];
-            if( st[Zp] > apogee ){
-                apogee = st[Zp];
-                apogeeTime = dat["t"];
+            if( newState[Zp] > apogee ){
+                apogee = newState[Zp];
+                apogeeTime = time;
+            }
+            if(_kpis.test(Kpis::MaxMach)){
+                kpis.maxMach = std::max(kpis.maxMach, stepDat[Telemetry::Mach]);
+            }
+            if(_kpis.test(Kpis::MaxDynamicPressure)){
+                kpis.maxDynamicPressure = std::max(kpis.maxDynamicPressure, stepDat[Telemetry::DynamicPressure]);
+            }
+            if(!_checkpoint && (time >= _checkpointTime || (_checkpointEvent != Events::LAST && _events.fired(_checkpointEvent)))){
+                Checkpoint cp;
+                cp.time = time;
+                cp.step = step;
+                cp.state = state;
+                std::tie(cp.derivative, cp.derivativeData) = k1Dat;
+                cp.counter = counter;
+                cp.compTime = totalTime;
+                cp.apogee = apogee;
+                cp.apogeeTime = apogeeTime;
+                cp.maxMach = kpis.maxMach;
+                cp.maxDynamicPressure = kpis.maxDynamicPressure;
+                cp.railExitVelocity = kpis.railExitVelocity;
+                cp.landingPosition = kpis.landingPosition;
+                saveSolverState(cp);
+                _checkpoint = cp;
             }
+            if(summaryOnly()){
+                continue;
+            }
+
+            FARSEER_PROFILE_START(outputStart);
+            const StateArray outState = externalState(newState);
+            if(writer){
+                writer->push(outState, stepDat);
+            }
+            if(record){
+                _trajectory.push(outState, stepDat);
+            }
+            FARSEER_PROFILE_RECORD(_profiler, Output, outputStart);
+        }
+        // the writer has been keeping up during the flight so this only flushes the last few rows
+        if(writer){
+            writer->close();
         }
-        fmt::print("{:.10f} m apogee at t = {:.10f}\n", apogee, apogeeTime);
 
-        // summing comp times
-        int totalTime = 0;
-        for(auto elem = stepData.begin(); elem != stepData.end(); elem++){
-            totalTime += (*elem)["ctime"];
+        // the located apogee falls between steps so it is preferred over the highest step
+        if(_events.fired(Events::Apogee)){
+            const auto& apogeeEvent = _events.record(Events::Apogee);
+            apogee = apogeeEvent.state[Zp];
+            apogeeTime = apogeeEvent.time;
+        }
+        _summary = { apogee, apogeeTime, time, NAN_D, NAN_D, counter };
+        _summary.maxMach = kpis.maxMach;
+        _summary.maxDynamicPressure = kpis.maxDynamicPressure;
+        _summary.railExitVelocity = kpis.railExitVelocity;
+        _summary.landingPosition = kpis.landingPosition;
+        _summary.stepLimited = stepLimited;
+        if(_events.fired(Events::RailExit)){
+            _summary.railExitTime = _events.record(Events::RailExit).time;
+        }
+        if(_events.fired(Events::Burnout)){
+            _summary.burnoutTime = _events.record(Events::Burnout).time;
+        }
+        if(verbose()){
+            fmt::print("{:.10f} m apogee at t = {:.10f}\n", apogee, apogeeTime);
+            fmt::print("comp time {} s, final step {} s num steps {}\n", totalTime/1e6, step, counter);
+            if(stepLimited) fmt::print("stopped at the step limit before landing\n");
         }
-        fmt::print("comp time {} s, final step {} s num steps {}\n", totalTime/1e6, step, counter);
 
-        // writing to file
-        auto fname = outFile();
-        const Eigen::IOFormat CSVFormat(Eigen::FullPrecision, Eigen::DontAlignCols, ", ", "\n");
-        std::ofstream resFile;
-        resFile.open(fname, std::ios::out | std::ios::trunc);
-        resFile << fmt::format("Xp, Xv, Yp, Yv, Zp, Zv, Phi, dPhi, Theta, dTheta, Psi, dPsi"); //dont need to include LAST
-        // writing custom data headers
-        std::vector<std::string> keys = {}; //getting keys in a specific order
-        for(auto el = stepData[0].begin(); el != stepData[0].end(); el++){
-            resFile << ", " << el->first;
-            keys.push_back(el->first);
-        }
-        resFile << "\n";
-        // writing results
-        fmt::print("writing results to file \"{}\"\n", fname.string());
-        auto defaultPrecision = resFile.precision();
-        // writing 
-        resFile << std::setprecision(std::numeric_limits<double>::digits10 + 1); // 17
-        for(int i = 0; i < states.size(); i++){
-            resFile << states[i].transpose().format(CSVFormat);
-            for(auto k = keys.begin(); k != keys.end(); k++){
-                resFile << ", " << stepData[i].at(*k);
-            }
-            resFile << "\n";
+        return externalState(state);
+    }
+
+    void Sim::resetEvents(){
+        // events are located on each steps interpolant rather than by checking the state after the step
+        _events = EventLocator();
+        _events.add({ Events::RailExit, [this](double, const StateArray& y){ return stateArrayPosition(y).norm() - rodLen(); }, 1, true });
+        if(_massTable){
+            // the mass table has already found the end of the burn, so the rocket isn't asked for its thrust at every step
+            const double burnout = _massTable->burnout();
+            _events.add({ Events::Burnout, [burnout](double t, const StateArray&){ return burnout - t; }, -1, true });
+        } else {
+            _events.add({ Events::Burnout, [this](double t, const StateArray&){ return _rocket->thrust(FlightState(t, 0, 0, 0, 0, 0)).norm(); }, -1, true });
+        }
+        _events.add({ Events::Apogee, [](double, const StateArray& y){ return y[Zv]; }, -1, false });
+        _events.add({ Events::GroundImpact, [this](double, const StateArray& y){ return takeoff() ? y[Zp] : 1.0; }, -1, true });
+    }
+
+    void Sim::saveSolverState( Checkpoint& checkpoint ) const {
+        checkpoint.rocket = _rocket;
+        checkpoint.onRod = _onRod;
+        checkpoint.takeoff = _takeoff;
+        checkpoint.rodVector = _rodVec;
+        checkpoint.events = _events.records();
+        checkpoint.seed = _seed;
+        std::ostringstream rng;
+        rng << _rng;
+        checkpoint.rng = rng.str();
+        checkpoint.integrator = _integrator;
+        checkpoint.attitudeRepresentation = _attitudeRepresentation;
+        checkpoint.attitudeReference = _attitudeReference;
+        checkpoint.lastError = _lastError;
+        checkpoint.lastRejected = _lastRejected;
+        checkpoint.nordsieck.assign(_nordsieck.cbegin(), _nordsieck.cend());
+        checkpoint.abmOrder = _abmOrder;
+        checkpoint.abmStep = _abmStep;
+        checkpoint.abmStepsSinceChange = _abmStepsSinceChange;
+        checkpoint.abmLastCorrection = _abmLastCorrection;
+        checkpoint.abmRestart = _abmRestart;
+        const HistoryView history = _history.view();
+        checkpoint.history.clear();
+        for(size_t k = history.size(); k > 0; k--){
+            checkpoint.history.push_back({ history.step(k), history.diff(k) });
+        }
+    }
+
+    void Sim::restoreSolverState( const Checkpoint& checkpoint ){
+        if(checkpoint.nordsieck.size() != _nordsieck.size()){
+            throw std::invalid_argument("the checkpoint was taken by a sim with a different adams order limit");
+        }
+        if(checkpoint.abmOrder < 1 || checkpoint.abmOrder > ABM_MAX_ORDER){
+            throw std::invalid_argument("the checkpoint holds an invalid adams order");
+        }
+        setIntegrator(static_cast<IntegrationStrats>(checkpoint.integrator));
+        _attitudeRepresentation = static_cast<AttitudeRepresentations>(checkpoint.attitudeRepresentation);
+        _attitudeReference = checkpoint.attitudeReference;
+        _onRod = checkpoint.onRod;
+        _takeoff = checkpoint.takeoff;
+        setRodVec(checkpoint.rodVector);
+        resetEvents();
+        _events.restore(checkpoint.events);
+        std::istringstream rng(checkpoint.rng);
+        rng >> _rng;
+        if(!rng){
+            throw std::invalid_argument("the checkpoint holds an invalid generator state");
+        }
+        _lastError = checkpoint.lastError;
+        _lastRejected = checkpoint.lastRejected;
+        std::copy(checkpoint.nordsieck.cbegin(), checkpoint.nordsieck.cend(), _nordsieck.begin());
+        _abmOrder = checkpoint.abmOrder;
+        _abmStep = checkpoint.abmStep;
+        _abmStepsSinceChange = checkpoint.abmStepsSinceChange;
+        _abmLastCorrection = checkpoint.abmLastCorrection;
+        _abmRestart = checkpoint.abmRestart;
+        _history.clear();
+        for(auto h = checkpoint.history.cbegin(); h != checkpoint.history.cend(); h++){
+            _history.push(h->first, h->second);
+        }
+    }
+
+    Eigen::Matrix3d Sim::rotation(const StateArray& state) const {
+        if(_attitudeRepresentation == QUATERNION){
+            return quaternionRotation(state, _attitudeReference);
+        }
+        return Utils::eulerToRotmat(state[Phi], state[Theta], state[Psi]);
+    }
+
+    Eigen::Matrix3d Sim::quaternionRotation(const StateArray& state, const Eigen::Quaterniond& reference){
+        const Eigen::Vector3d v = stateArrayOrientation(state);
+        const double w = std::sqrt(std::max(0.0, 1 - v.squaredNorm()));
+        return (reference*Eigen::Quaterniond(w, v.x(), v.y(), v.z())).toRotationMatrix();
+    }
+
+    StateArray Sim::quaternionToEuler(const StateArray& state, const Eigen::Quaterniond& reference){
+        const Eigen::Vector3d angles = Utils::rotmatToEuler(quaternionRotation(state, reference));
+        StateArray external = state;
+        external[Phi] = angles.x(); external[Theta] = angles.y(); external[Psi] = angles.z();
+        return external;
+    }
+
+    StateArray Sim::internalState(const StateArray& state){
+        if(_attitudeRepresentation != QUATERNION){
+            return state;
         }
+        _attitudeReference = Eigen::Quaterniond(Utils::eulerToRotmat(state[Phi], state[Theta], state[Psi]));
+        StateArray internal = state;
+        internal[Phi] = 0; internal[Theta] = 0; internal[Psi] = 0;
+        return internal;
+    }
 
-        resFile << std::setprecision(defaultPrecision);
+    StateArray Sim::externalState(const StateArray& state) const {
+        if(_attitudeRepresentation != QUATERNION){
+            return state;
+        }
+        return quaternionToEuler(state, _attitudeReference);
+    }
 
-        resFile.close();
+    StateArray Sim::externalState(const Checkpoint& checkpoint){
+        if(checkpoint.attitudeRepresentation != QUATERNION){
+            return checkpoint.state;
+        }
+        return quaternionToEuler(checkpoint.state, checkpoint.attitudeReference);
+    }
 
-        return *(states.rbegin());
+    bool Sim::rebaseAttitude(StateArray& state){
+        if(_attitudeRepresentation != QUATERNION || stateArrayOrientation(state).squaredNorm() < ATTITUDE_REBASE){
+            return false;
+        }
+        // renormalizing here keeps rounding from building up in the reference
+        _attitudeReference = Eigen::Quaterniond(rotation(state)).normalized();
+        state[Phi] = 0; state[Theta] = 0; state[Psi] = 0;
+        return true;
     }
     
     std::tuple<double, StateArray, StepData> Sim::eulerIntegrate( const double time, const double step, const StateArray* state, const StateArray* lastState){
@@ -219,244 +499,252 @@ namespace Sim{
         return { newTime, newState, std::get<1>(k1Dat)};
     }
    
-    std::tuple<double, StateArray, StepData> Sim::adaptiveRKIntegrate( const double time, const double step, const StateArray state, const double rtol, const double atol){
-        bool errPass = false;
-        
-        double newStep = step;
-        double usedStep = step;
-        StateArray newState;
-        StepData stateData;
-
-        while(!errPass){
-            // initializing new state and k vector
-            newState = state;
-            std::vector<StateArray> ks = {};
-            for(int i = 0; i < RK_A.size(); i++){
-                // calculating x val
-                double xVal = time + newStep*RK_A[i];
-                // adding weighted sum of previous ks to y value
-                StateArray yVal = state;
-                for(int j = 0; j < ks.size(); j++){
-                    yVal += RK_B(i,j)*ks[j];
-                }
-                // calculating this k value
-                auto thisKdat = calculate(xVal, yVal);
-                auto thisK = std::get<0>(thisKdat);
-                stateData = std::get<1>(thisKdat);
-                thisK *= newStep;
-                ks.push_back(thisK);
-            }
-            usedStep = newStep;
-            // calculating the final output and output error
-            StateArray err = StateArray::Zero();
-            //std::cout << ks.size() << "\n";
-            for(int i = 0; i < ks.size(); i++){
-                newState += RK_CH[i]*ks[i];
-                err += RK_CT[i]*ks[i];
-            }
-            double eps = ((newState.abs()*rtol) + atol).sum();
-
-            //std::cout << "new step " << newStep << "\neps " << eps << "\nerr " << err << "\n";
-            newStep = (0.9 * newStep * std::pow(eps/err.sum(),0.2));
-            if( err.sum() <= eps ){
-                errPass = true;
-            } else {
-                errPass = false;
+    StepResult Sim::DP45Step( const double time, const double step, const StateArray* state, const std::tuple<StateArray, StepData>* k1Dat){
+        // stages are kept in fixed arrays so an attempt does not allocate
+        std::array<StateArray, 7> k;
+        std::array<StepData, 7> data;
+        k[0] = std::get<0>(*k1Dat);
+        data[0] = std::get<1>(*k1Dat);
+        StateArray yVal = *state;
+        for(int i = 1; i < RK_A.size(); i++){
+            yVal = *state;
+            for(int j = 0; j < i; j++){
+                yVal += step*RK_B(i,j)*k[j];
             }
+            auto kDat = calculate(time + step*RK_A[i], yVal);
+            k[i] = std::get<0>(kDat);
+            data[i] = std::get<1>(kDat);
         }
-        //fmt::print("t = {:<8.3}, step {:<8.3} new state [{}]\n", time, newStep, toString(newState.transpose()));
-        return {time+usedStep, newState, stateData};
-    }
-    
-
-    std::tuple<double, StateArray, StepData> Sim::ABRKIntegrate(
-        const double time, const double step, const StateArray* state, const StateArray* lastState,
-        const std::vector<StateArray>* diffs, const std::vector<StepData>* stepData, const std::vector<double>* steps
-        ){
-        std::tuple<StateArray, StepData> k1Dat = calculate(time, *state);
-        StateArray k1 = std::get<0>(k1Dat);
-        auto newStep = selectTimeStep(state, &k1, step);
-
-        if(diffs->size() < 8) // not enough steps to do AB4 integration
-        {
-            return RK4Integrate(time, newStep, state, &k1Dat);
+        // the last stage is evaluated at the fifth order solution, so it is the derivative at the new state (first same as last)
+        const StateArray newState = yVal;
+
+        StateArray err = StateArray::Zero();
+        StateArray r5 = StateArray::Zero();
+        StepData stepDat = StepData::Zero();
+        for(int i = 0; i < RK_A.size(); i++){
+            err += step*RK_CT[i]*k[i];
+            r5 += step*RK_D[i]*k[i];
+            stepDat += RK_CH[i]*data[i];
         }
-        // check if the last 3 steps are the same as the selected one
-        bool stepIsSame = true;
-        auto stepRevIter = steps->crbegin();
+        // scaled rms norm so that each component is judged against its own tolerance
+        const double errNorm = errorNorm(err, *state, newState);
 
-        for(int i = 0; i < 8; i++){
-            if( std::abs((*stepRevIter) - newStep) > std::numeric_limits<double>::epsilon() ) // checking if steps are equal accounting for floating point badness
-            {
-                stepIsSame = false;
-                break;
-            }
-            stepRevIter++;
-        }
+        const StateArray yDiff = newState - *state;
+        const StateArray bspl = step*k[0] - yDiff;
+        DenseOutput dense(time, step, *state, yDiff, bspl, yDiff - step*k[6] - bspl, r5);
 
-        std::tuple<double, StateArray, StepData> newdata;
-        if(stepIsSame){
-            newdata = AB44Integrate(time, newStep, state, diffs, stepData, &k1Dat);
-        } else {
-            newdata = RK4Integrate(time, newStep, state, &k1Dat);
-        }
-        return newdata;
+        return { time+step, newState, stepDat, { k[6], data[6] }, dense, errNorm, step };
     }
 
-    std::tuple<double, StateArray, StepData> Sim::AB4Integrate(
-        const double time, const double step, const StateArray* state, const std::vector<StateArray>* diffs,
-        const std::vector<StepData>* stepData, const std::tuple<StateArray, StepData>* inK1Dat
-        ){
-        auto diffSiz = diffs->size();
-        
-        if(diffSiz < 5) // not enough steps to do integration
-        {
-            if(std::get<0>(*inK1Dat).hasNaN()){
-                return RK4Integrate(time, step, state);
-            } else {
-                return RK4Integrate(time, step, state, inK1Dat);
+    StepResult Sim::DP45Integrate( const double time, const double step, const StateArray* state, const std::tuple<StateArray, StepData>* k1Dat){
+        // PI controller constants from hairer's DOPRI5
+        static const double safety = 0.9;
+        static const double minFactor = 0.2;
+        static const double maxFactor = 10;
+        static const double beta = 0.04;
+        static const double alpha = 0.2 - 0.75*beta;
+
+        double thisStep = std::max(step, MIN_ADAPTIVE_STEP);
+        while(true){
+            FARSEER_PROFILE_START(attempt);
+            StepResult res = DP45Step(time, thisStep, state, k1Dat);
+            // the margin is for shrinking onto the floor rounding just above it
+            const bool floored = thisStep <= MIN_ADAPTIVE_STEP*(1 + 1e-9);
+            if(res.error <= 1 || floored){
+                FARSEER_PROFILE_RECORD(_profiler, AcceptedStep, attempt);
+                double factor = res.error == 0 ? maxFactor : safety*std::pow(res.error, -alpha)*std::pow(_lastError, beta);
+                factor = std::clamp(factor, minFactor, maxFactor);
+                // not growing straight after a rejection stops the controller from oscillating
+                if(_lastRejected){
+                    factor = std::min(factor, 1.0);
+                }
+                _lastError = std::max(res.error, 1e-4);
+                _lastRejected = false;
+                res.nextStep = std::max(thisStep*factor, MIN_ADAPTIVE_STEP);
+                return res;
             }
-            //return eulerIntegrate(time, step, state, lastState);
+            FARSEER_PROFILE_RECORD(_profiler, RejectedStep, attempt);
+            _lastRejected = true;
+            thisStep = std::max(thisStep*std::max(minFactor, safety*std::pow(res.error, -alpha)), MIN_ADAPTIVE_STEP);
         }
+    }
 
-        std::tuple<StateArray, StepData> k1Dat;
-        if(std::get<0>(*inK1Dat).hasNaN()){
-            k1Dat = calculate(time, *state);
-        } else {
-            k1Dat = *inK1Dat;
+    StepResult Sim::ABMIntegrate( const double time, const double step, const StateArray* state, const std::tuple<StateArray, StepData>* k1Dat){
+        static const double safety = 0.9;
+        static const double minFactor = 0.2;
+        static const double maxFactor = 5;
+
+        const StateArray& f0 = std::get<0>(*k1Dat);
+        if(_abmRestart){
+            // starting again at first order from the derivative at the current state, a step collapsed by the last discontinuity is not carried over
+            _abmOrder = 1;
+            _abmStep = std::max(step, MIN_ADAPTIVE_STEP);
+            _nordsieck[0] = *state;
+            _nordsieck[1] = _abmStep*f0;
+            _abmStepsSinceChange = 0;
+            _abmRestart = false;
         }
 
-        StateArray k1 = std::get<0>(k1Dat);
-        StateArray k2 = diffs->at(diffSiz-1);
-        StateArray k3 = diffs->at(diffSiz-2);
-        StateArray k4 = diffs->at(diffSiz-3);
-        StateArray k5 = diffs->at(diffSiz-4);
+        while(true){
+            FARSEER_PROFILE_START(attempt);
+            const int q = _abmOrder;
+            const double h = _abmStep;
 
-        //StateArray newState = (*state) + step*(55.0*k1 - 59.0*k2 + 37.0*k3 - 9.0*k4)/24.0;
-        StateArray newState = (*state) + step*((1901.0*k1 - 2774.0*k2 + 2616.0*k3 - 1274.0*k4 + 251.0*k5)/720);
+            // predicting by taylor expanding the history, which is multiplying it by the pascal triangle
+            std::array<StateArray, ABM_MAX_ORDER + 1> predicted;
+            for(int j = 0; j <= q; j++){
+                predicted[j] = _nordsieck[j];
+            }
+            for(int k = 0; k < q; k++){
+                for(int j = q; j > k; j--){
+                    predicted[j-1] += predicted[j];
+                }
+            }
 
-        return { time+step, newState, std::get<1>(k1Dat)};
-    }
+            // evaluating at the prediction and correcting
+            auto predictedDat = calculate(time + h, predicted[0]);
+            const StateArray correction = h*std::get<0>(predictedDat) - predicted[1];
+            const StateArray newState = predicted[0] + ABM_L(q,0)*correction;
+            const double err = errorNorm(ABM_ERR[q]*correction, *state, newState);
+
+            // the rocket's forces switch with its flags and the damping with the sign of the rates, a step across one of these
+            // can't meet the tolerances at any size so the step is floored rather than shrunk until it underflows,
+            // the margin is for rescaling onto the floor rounding just above it
+            const bool floored = h <= MIN_ADAPTIVE_STEP*(1 + 1e-9);
+            if(err > 1 && !floored){
+                double factor = std::max({ minFactor, safety*std::pow(err, -1.0/(q+1)), MIN_ADAPTIVE_STEP/h });
+                rescaleNordsieck(factor);
+                _abmStepsSinceChange = 0;
+                FARSEER_PROFILE_RECORD(_profiler, RejectedStep, attempt);
+                continue;
+            }
 
-    std::tuple<double, StateArray, StepData> Sim::AB22Integrate(
-        const double time, const double step, const StateArray* state, const std::vector<StateArray>* diffs,
-        const std::vector<StepData>* stepData, const std::tuple<StateArray, StepData>* inK1Dat
-        ){
-        auto diffSiz = diffs->size();
-        
-        if(diffSiz < 4) // not enough steps to do integration
-        {
-            if(std::get<0>(*inK1Dat).hasNaN()){
-                return RK4Integrate(time, step, state);
-            } else {
-                return RK4Integrate(time, step, state, inK1Dat);
+            // evaluating at the corrected state, the history is updated with this derivative
+            auto endDat = calculate(time + h, newState);
+            const StateArray endCorrection = h*std::get<0>(endDat) - predicted[1];
+            _nordsieck[0] = newState;
+            for(int j = 1; j <= q; j++){
+                _nordsieck[j] = predicted[j] + ABM_L(q,j)*endCorrection;
+            }
+            _abmStepsSinceChange++;
+
+            // the step and order are only reconsidered once the history has been built at the current ones
+            double factor = 1;
+            if(_abmStepsSinceChange > q){
+                factor = safety*std::pow(std::max(err, 1e-10), -1.0/(q+1));
+                int newOrder = q;
+                if(q > 1){
+                    // the error the order below would have made is set by the highest derivative held
+                    double errDown = errorNorm(ABM_ERR[q-1]*q*_nordsieck[q], *state, newState);
+                    double downFactor = safety*std::pow(std::max(errDown, 1e-10), -1.0/q);
+                    if(downFactor > factor){
+                        factor = downFactor;
+                        newOrder = q-1;
+                    }
+                }
+                if(q < ABM_MAX_ORDER){
+                    // the order above needs the next derivative, which shows up as the change in the correction between steps
+                    double errUp = errorNorm(ABM_ERR[q+1]*(correction - _abmLastCorrection)/(q+1), *state, newState);
+                    double upFactor = safety*std::pow(std::max(errUp, 1e-10), -1.0/(q+2));
+                    if(upFactor > factor){
+                        factor = upFactor;
+                        newOrder = q+1;
+                        _nordsieck[q+1] = correction/(q+1);
+                    }
+                }
+                _abmOrder = newOrder;
+                // small increases aren't worth losing the history over
+                if(factor >= 1 && factor < 1.2){
+                    factor = 1;
+                }
+                factor = std::clamp(factor, std::max(minFactor, MIN_ADAPTIVE_STEP/_abmStep), maxFactor);
+                if(factor != 1 || newOrder != q){
+                    rescaleNordsieck(factor);
+                    _abmStepsSinceChange = 0;
+                }
+            }
+            _abmLastCorrection = correction;
+            if(err > 1){
+                // a floored step that missed the tolerances spans a discontinuity, so the history is rebuilt past it
+                _abmRestart = true;
             }
-            //return eulerIntegrate(time, step, state, lastState);
-        }
 
-        std::tuple<StateArray, StepData> k1Dat;
-        if(std::get<0>(*inK1Dat).hasNaN()){
-            k1Dat = calculate(time, *state);
-        } else {
-            k1Dat = *inK1Dat;
+            DenseOutput dense = DenseOutput::hermite(time, h, *state, f0, newState, std::get<0>(endDat));
+            FARSEER_PROFILE_RECORD(_profiler, AcceptedStep, attempt);
+            return { time+h, newState, std::get<1>(endDat), endDat, dense, err, _abmStep };
         }
+    }
 
+    void Sim::rescaleNordsieck(double factor){
+        double scale = 1;
+        for(int j = 1; j <= _abmOrder; j++){
+            scale *= factor;
+            _nordsieck[j] *= scale;
+        }
+        _abmStep *= factor;
+    }
 
-        // getting derivatives
-        StateArray zn3o = std::get<0>(k1Dat); // this will end up replaced, and is used to get the derivative
-        StateArray zn2o = diffs->at(diffSiz-1);
-        StateArray zn1 = diffs->at(diffSiz-2);
-        StateArray zn = diffs->at(diffSiz-3);
-        // getting second derivatives
-        StateArray znp = (zn1-zn)/step;
-        StateArray zn1p = (zn2o-zn1)/step;
-        StateArray zn2p = (zn3o-zn2o)/step;
-
-        // forming new derivatives
-        StateArray zn2 = zn1 + step/2*(3*zn1p - znp);
-        StateArray zn3 = zn2 + step/2*(3*zn2p - zn1p);
-
-        // getting new difference
-        StateArray diff = step/2*(3*zn3 - zn2);
-
-        StateArray newState = (*state) + diff;// + dvdt*step;
-
-        return { time+step, newState, std::get<1>(k1Dat)};
+    double Sim::errorNorm(const StateArray& err, const StateArray& y0, const StateArray& y1) const {
+        const StateArray scale = _atol + _rtol*y0.abs().max(y1.abs());
+        return std::sqrt((err/scale).square().mean());
     }
 
-    std::tuple<double, StateArray, StepData> Sim::AB44Integrate(
-        const double time, const double step, const StateArray* state, const std::vector<StateArray>* diffs,
-        const std::vector<StepData>* stepData, const std::tuple<StateArray, StepData>* inK1Dat
-        ){
-        auto diffSiz = diffs->size();
-        
-        if(diffSiz < 8) // not enough steps to do integration
-        {
-            if(std::get<0>(*inK1Dat).hasNaN()){
-                return RK4Integrate(time, step, state);
-            } else {
-                return RK4Integrate(time, step, state, inK1Dat);
-            }
-            //return eulerIntegrate(time, step, state, lastState);
+    StepResult Sim::takeStep( const double time, const double step, const StateArray* state, const std::tuple<StateArray, StepData>* k1Dat){
+        if(integrator() == DP45){
+            return DP45Step(time, step, state, k1Dat);
         }
+        // adams steps can't be taken on demand without a history, so RK4 is used for them here
+        auto [newTime, newState, stepDat] = RK4Integrate(time, step, state, k1Dat);
+        auto endDat = calculate(newTime, newState);
+        DenseOutput dense = DenseOutput::hermite(time, step, *state, std::get<0>(*k1Dat), newState, std::get<0>(endDat));
+        return { newTime, newState, stepDat, endDat, dense, 0, step };
+    }
 
-        std::tuple<StateArray, StepData> k1Dat;
-        if(std::get<0>(*inK1Dat).hasNaN()){
-            k1Dat = calculate(time, *state);
-        } else {
-            k1Dat = *inK1Dat;
+    void Sim::setIntegrator( IntegrationStrats integrator ){
+        if(integrator != RK4 && integrator != AB && integrator != DP45 && integrator != ABM){
+            throw std::invalid_argument("only RK4, AB, DP45 and ABM integration are supported by solve");
         }
+        _integrator = integrator;
+    }
+    
 
-
-        // getting derivatives
-        StateArray zn7o = std::get<0>(k1Dat); // this will end up replaced, and is used to get the derivative
-        StateArray zn6o = diffs->at(diffSiz-1);
-        StateArray zn5o = diffs->at(diffSiz-2);
-        StateArray zn4o = diffs->at(diffSiz-3);
-        StateArray zn3 = diffs->at(diffSiz-4);
-        StateArray zn2 = diffs->at(diffSiz-5);
-        StateArray zn1 = diffs->at(diffSiz-6);
-        StateArray zn = diffs->at(diffSiz-7);
-        // getting second derivatives
-        StateArray znp = (zn1-zn)/(step);
-        StateArray zn1p = (zn2-zn1)/(step);
-        StateArray zn2p = (zn3-zn2)/(step);
-        StateArray zn3p = (zn4o-zn3)/(step);
-        StateArray zn4p = (zn5o-zn4o)/(step);
-        StateArray zn5p = (zn6o-zn5o)/(step);
-        StateArray zn6p = (zn7o-zn6o)/(step);
-        // forming new derivatives
-
-        StateArray zn4 = zn3 + step/24*(55*zn3p - 59*zn2p + 37*zn1p - 9*znp);
-        StateArray zn5 = zn4 + step/24*(55*zn4p - 59*zn3p + 37*zn2p - 9*zn1p);
-        StateArray zn6 = zn5 + step/24*(55*zn5p - 59*zn4p + 37*zn3p - 9*zn2p);
-        StateArray zn7 = zn6 + step/24*(55*zn6p - 59*zn5p + 37*zn4p - 9*zn3p);
-        // getting new difference
-        StateArray diff = step/24*(55*zn7 - 59*zn6 + 37*zn5 - 9*zn4);
-
-        StateArray newState = (*state) + diff;// + dvdt*step;
-
-        StepData avgDat = {};
-        
-        auto zn7dat = std::get<1>(k1Dat);
-        /*
-        auto zn6dat = stepData->at(diffSiz-1);
-        auto zn5dat = stepData->at(diffSiz-2);
-        auto zn4dat = stepData->at(diffSiz-3);
-        for(auto i = zn7dat.begin(); i != zn7dat.end(); i++){
-            auto k = i->first;
-            double avg = 55.0/24*zn7dat[k] - 59.0/24*zn6dat[k] + 37.0/24*zn5dat[k] - 9.0/24 * zn4dat[k];
-            avgDat[k] = avg;
+    StepResult Sim::ABRKIntegrate(
+        const double time, const double step, const StateArray* state, const std::tuple<StateArray, StepData>* k1Dat, HistoryView history
+        ){
+        // AB4 needs 3 steps of this size behind it, anything else is an RK4 step
+        bool stepIsSame = history.size() >= 3;
+        for(size_t k = 1; stepIsSame && k <= 3; k++){
+            // the steps are differences of times so they are only equal to within the rounding of the times
+            stepIsSame = std::abs(history.step(k) - step) <= 64*std::numeric_limits<double>::epsilon()*std::max(std::abs(time), 1.0);
         }
-        */
-
-        auto correctorData = calculate(time+step, newState);
 
-        StateArray corrctorState = std::get<0>(correctorData);
-
-        StateArray finalState = (*state) + step/24*(9*corrctorState + 19*zn7o - 5*zn6o + zn5o);
+        auto [newTime, newState, stepDat] = stepIsSame ? AB4Integrate(time, step, state, history, k1Dat) : RK4Integrate(time, step, state, k1Dat);
+        auto endDat = calculate(newTime, newState);
+        DenseOutput dense = DenseOutput::hermite(time, step, *state, std::get<0>(*k1Dat), newState, std::get<0>(endDat));
+        return { newTime, newState, stepDat, endDat, dense, 0, step };
+    }
 
-        return { time+step, finalState, zn7dat};
+    std::tuple<double, StateArray, StepData> Sim::AB4Integrate(
+        const double time, const double step, const StateArray* state, HistoryView history,
+        const std::tuple<StateArray, StepData>* k1Dat
+        ){
+        if(history.size() < 3) // not enough steps to do integration
+        {
+            return RK4Integrate(time, step, state, k1Dat);
+        }
+        // derivatives at the start of this step and the three before it
+        const StateArray& fn = std::get<0>(*k1Dat);
+        const StateArray& fn1 = history.diff(1);
+        const StateArray& fn2 = history.diff(2);
+        const StateArray& fn3 = history.diff(3);
+
+        // predicting with adams bashforth
+        StateArray predicted = (*state) + step/24*(55*fn - 59*fn1 + 37*fn2 - 9*fn3);
+        // and correcting once with adams moulton from the derivative at the prediction
+        StateArray corrector = std::get<0>(calculate(time + step, predicted));
+        StateArray newState = (*state) + step/24*(9*corrector + 19*fn - 5*fn1 + fn2);
+
+        return { time+step, newState, std::get<1>(*k1Dat)};
     }
 
     std::tuple<double, StateArray, StepData> Sim::ORKIntegrate( const double time, const double step, const StateArray* state, const StateArray* lastState){
@@ -488,17 +776,8 @@ namespace Sim{
 
         StateArray newState = (*state) + step/6*(k1 + 2*k2 + 2*k3 + k4);
 
-        StepData stepDatAvg = {}; // weighted avg of all step data
-        StepData k1St = std::get<1>(k1Dat);
-        StepData k2St = std::get<1>(k2Dat);
-        StepData k3St = std::get<1>(k3Dat);
-        StepData k4St = std::get<1>(k4Dat);
-
-        for(auto el = k1St.begin(); el != k1St.end(); el++){
-            auto key = el->first;
-            auto avg = (k1St[key] + 2*k2St[key] + 2*k3St[key] + k4St[key])/6;
-            stepDatAvg[key] = avg;
-        }
+        // weighted avg of all step data
+        StepData stepDatAvg = (std::get<1>(k1Dat) + 2*std::get<1>(k2Dat) + 2*std::get<1>(k3Dat) + std::get<1>(k4Dat))/6;
 
         std::tuple<double, StateArray, StepData> res = {time+step, newState, stepDatAvg};
         return res;
@@ -516,14 +795,14 @@ namespace Sim{
         Eigen::Array<double, 8, 1> stepCandidates = Eigen::Array<double, 8, 1>::Ones() * std::numeric_limits<double>::max();
         stepCandidates[0] = std::max(userStep(), minTimeStep); // the current time step
         //stepCandidates[1] = ; // the maximum allowed time step
-        stepCandidates[2] = std::abs(maxAngleStep/ std::sqrt(std::pow((*k1)[Theta],2) + std::pow((*k1)[Psi],2) )); // the maximum pitch rate per second
+        // the angle cap keeps euler angles away from large steps near gimbal lock, a quaternion attitude doesn't need it
+        if(_attitudeRepresentation == EULER_ANGLES){
+            stepCandidates[2] = std::abs(maxAngleStep/ std::sqrt(std::pow((*k1)[Theta],2) + std::pow((*k1)[Psi],2) )); // the maximum pitch rate per second
+        }
         // the max roll rate
         // the max roll rate change
         stepCandidates[5] = std::abs(maxPitchStepChange/ std::sqrt(std::pow((*k1)[dTheta],2) + std::pow((*k1)[dPsi],2)) );
-        if(onRod()){
-            stepCandidates[0] /= 5;
-            stepCandidates[6] = (rodLen()/stateArrayPosition(*k1).norm())/10;
-        }
+        // rail exit is located on each step's interpolant so the rod no longer needs a shorter step
         stepCandidates[7] = 1.5*currStep;
         assert(!stepCandidates.hasNaN());
         auto chosenStep = stepCandidates.minCoeff();
@@ -534,6 +813,7 @@ namespace Sim{
 
 
     std::tuple<StateArray, StepData> Sim::calculate( const double time, const StateArray state ){
+        FARSEER_PROFILE_SCOPE(_profiler, Calculate);
         //fmt::print("TIME {}, IN [{}]\n", time, toString(state.transpose()));
         StateArray res = defaultDeriv(state);
         //fmt::print("TIME {}, INITRES [{}]\n", time, toString(res.transpose()));
@@ -543,6 +823,14 @@ namespace Sim{
         // getting velocity vectors
         const Eigen::Vector3d velocity = stateArrayVelocity(state);
         const Eigen::Vector3d angVelocity = stateArrayAngVelocity(state); //yaw, pitch, roll
+        if(_attitudeRepresentation == QUATERNION){
+            // the vector part v of the rotation since the reference follows dq/dt = q*(0, w)/2 for body rates w
+            const double qw = std::sqrt(std::max(0.0, 1 - orientation.squaredNorm()));
+            const Eigen::Vector3d dv = 0.5*(qw*angVelocity + orientation.cross(angVelocity));
+            res[Phi] = dv.x();
+            res[Theta] = dv.y();
+            res[Psi] = dv.z();
+        }
         // initializing acceleration vectors
         Eigen::Vector3d forces = Eigen::Vector3d::Zero();
         Eigen::Vector3d acceleration = Eigen::Vector3d::Zero();
@@ -555,27 +843,30 @@ namespace Sim{
         double gam = 1.4; // 1.4 gamma as flying through air is assumed
 
         // getting mach and AoA
-        Eigen::Matrix3d rocketRotationMat = Utils::eulerToRotmat(orientation.x(), orientation.y(), orientation.z());
+        Eigen::Matrix3d rocketRotationMat = rotation(state);
         Eigen::Vector3d rocketOrientationVec = rocketRotationMat*thisWayUp(); // the rockets current "up" vector in global coords
         // getting atmospheric properties
         const double alt = altitude(position);
-        const auto g = _atmos->g(alt);
-        const auto atmDens = _atmos->density(alt);
-        const auto atmTemp = _atmos->temperature(alt);
-        const auto cSound = _atmos->sound(alt);
-        const auto pres = _atmos->pressure(alt);
+        FARSEER_PROFILE_START(atmosStart);
+        const RealAtmos::AtmosProperties atmos = _atmosTable ? _atmosTable->properties(alt) : _atmos->properties(alt);
+        FARSEER_PROFILE_RECORD(_profiler, Atmosphere, atmosStart);
+        const double g = atmos.g;
+        const double atmDens = atmos.density;
+        const double cSound = atmos.sound;
+        const double pres = atmos.pressure;
+        const double kinVisc = atmos.kinematic_viscosity;
         //fmt::print("TIME: {}, STATE [{}]\n", time, toString(state.transpose()));
         //fmt::print("ATM CONDS: pos = [{}] alt = {}, g = {}, cSound = {}, atmDens = {}, pres = {}\n", toString(position.transpose()), alt, g, atmDens, cSound, pres);
 
         // getting wind velocity
-        const Eigen::Vector3d windVel = wind(position);
+        const Eigen::Vector3d windVel = wind(alt, time);
         const Eigen::Vector3d relativeVelocity = velocity - windVel; // velocity of the rocket relative to the wind, this is opposite freestream velocity (-v_0)
         const double relativeSpeed = relativeVelocity.norm();
 
-        const double mach = velocity.norm()/cSound;
+        const double mach = relativeSpeed/cSound;
         if(std::isnan(mach)){
             fmt::print("TIME: {}, STATE AT FAILURE [{}]\n", time, toString(state.transpose()));
-            fmt::print("MACH IS NAN vel.norm = [{}], csound = {}\n", velocity.norm(), cSound);
+            fmt::print("MACH IS NAN relvel.norm = [{}], csound = {}\n", relativeSpeed, cSound);
             assert(!std::isnan(mach));
         }
 
@@ -598,7 +889,6 @@ namespace Sim{
             assert(!std::isnan(angleOfAttack));
         }
         // getting reynolds number
-        const double kinVisc = _atmos->kinematic_viscosity(alt);
         const double reynL = relativeVelocity.norm()/kinVisc;
         // getting angular velocities for damping
         const double pitchVel = angVelocity.x();
@@ -608,24 +898,32 @@ namespace Sim{
             time, mach, angleOfAttack, pitchVel, yawVel, reynL, gam
         );
 
+        // everything needed from the rocket in one call
+        FARSEER_PROFILE_START(aeroStart);
+        const RocketSnapshot rocketVals = _rocket->evaluate(currState, !_massTable);
+        FARSEER_PROFILE_RECORD(_profiler, Aero, aeroStart);
+
         // get rocket reference area and length
-        const double _aRef = _rocket->referenceArea(currState);
-        const double _lRef = _rocket->referenceLength(currState);
+        const double _aRef = rocketVals.referenceArea;
+        const double _lRef = rocketVals.referenceLength;
 
         /*
         --------------------------
         --- THRUST AND GRAVITY ---
         --------------------------
         */
-        auto m = _rocket->mass(currState);
-        const Eigen::Matrix3d inertia = (_rotmat*_rocket->inertia(currState)*(_rotmat.transpose()));
+        FARSEER_PROFILE_START(massStart);
+        const MassProperties massProps = _massTable ? _massTable->at(time) : MassTable::evaluate(rocketVals, _rotmat);
+        FARSEER_PROFILE_RECORD(_profiler, MassProperties, massStart);
+        const double m = massProps.mass;
+        const Eigen::Matrix3d& inertia = massProps.inertia;
         const double Ixx = inertia(0,0);
         const double Iyy = inertia(1,1);
         const double Izz = inertia(2,2);
 
 
         // adding thrust
-        Eigen::Vector3d th = rocketRotationMat*_rotmat*(_rocket->thrust(currState));
+        Eigen::Vector3d th = rocketRotationMat*_rotmat*(rocketVals.thrust);
         forces += th;
 
         // adding gravity
@@ -644,7 +942,7 @@ namespace Sim{
         ---------------------------
         */
 
-        auto cn = _rocket->c_n(currState);
+        auto cn = rocketVals.c_n;
         if(std::isnan(cn)){
             fmt::print("TIME {}, STATE AT FAILURE [{}]\n", time, toString(state.transpose()));
             fmt::print("CN IS NAN M={:.4f} AoA={:.4f}\n", mach, angleOfAttack);
@@ -672,8 +970,8 @@ namespace Sim{
         
         //fmt::print("t={:<8.4f} norm force     [{}]\n", time, toString(normForce.transpose()));
 
-        Eigen::Vector3d rockCP = _rotmat*_rocket->cp(currState);
-        Eigen::Vector3d rockCM = _rotmat*_rocket->cm(currState);
+        Eigen::Vector3d rockCP = _rotmat*rocketVals.cp;
+        Eigen::Vector3d rockCM = massProps.cm;
         Eigen::Vector3d globCP = rocketRotationMat*rockCP;
         Eigen::Vector3d globCM = rocketRotationMat*rockCM;
 
@@ -682,8 +980,8 @@ namespace Sim{
         assert(!normMoments.hasNaN());
 
         // adding damping
-        auto yawDampingCoeff = _rocket->c_m_damp_yaw(currState);
-        auto pitchDampingCoeff = _rocket->c_m_damp_pitch(currState);
+        auto yawDampingCoeff = rocketVals.c_m_damp_yaw;
+        auto pitchDampingCoeff = rocketVals.c_m_damp_pitch;
 
         Eigen::Vector3d yawDampingMoment = { yawDampingCoeff*_aRef*_lRef*dynamicPressure, 0, 0 };
         Eigen::Vector3d pitchDampingMoment = { 0, pitchDampingCoeff*_aRef*_lRef*dynamicPressure, 0 };
@@ -711,9 +1009,9 @@ namespace Sim{
 
         Eigen::Vector3d dragDir = -relativeVelocity.normalized(); // drag occurs in opposite direction to relative velocity
 
-        double cdf = _rocket->Cdf(currState);
-        double cdp = _rocket->Cdp(currState);
-        double cdb = _rocket->Cdb(currState);
+        double cdf = rocketVals.Cdf;
+        double cdp = rocketVals.Cdp;
+        double cdb = rocketVals.Cdb;
         double cd = cdf + cdp + cdb;
         double dragMag = cd*_aRef*dynamicPressure;
 
@@ -749,13 +1047,14 @@ namespace Sim{
 
 
         // adding random pitch and yaw to flight
-        double randPitchCoeff = (((double) std::rand())/RAND_MAX - 0.5)*2*0.0005;
-        double randYawCoeff = (((double) std::rand())/RAND_MAX - 0.5)*2*0.0005;
+        std::uniform_real_distribution<double> randMomentDist(-0.0005, 0.0005);
+        double randPitchCoeff = randMomentDist(_rng);
+        double randYawCoeff = randMomentDist(_rng);
 
         moments += Eigen::Vector3d{ randYawCoeff, randPitchCoeff, 0 }*_aRef*_lRef*dynamicPressure;
         assert(!moments.hasNaN());
         // adding moments to angular acceleration
-        angAcceleration += inertia.inverse()*moments;
+        angAcceleration += massProps.inverseInertia*moments;
         
 
         assert(!acceleration.hasNaN());
@@ -780,7 +1079,7 @@ namespace Sim{
             fmt::println("Abnormally large ang acceleration [{}]",toString(angAcceleration.transpose()));
             fmt::println("TIME {}, STATE AT FAILURE [{}]\nm = {}, AoA = {} cn = {} Cdf = {:<.8f}, Cdp = {:<.8f}, Cdb = {:<.8f}", time, toString(state.transpose()), mach, angleOfAttack, cn, cdf, cdp, cdf);
             fmt::println("rho = {}, dragDir = [{}], normdir = [{}], pitchDampingC = {}, yawDampingC = {}", atmDens, toString(dragDir.transpose()), toString(normForceDirection.transpose()), pitchDampingCoeff, yawDampingCoeff);
-            fmt::println("norm moments = [{}], norm accs = [{}], dynPres = {}", toString(normMoments.transpose()), toString((inertia.inverse()*normMoments).transpose() ), dynamicPressure);
+            fmt::println("norm moments = [{}], norm accs = [{}], dynPres = {}", toString(normMoments.transpose()), toString((massProps.inverseInertia*normMoments).transpose() ), dynamicPressure);
             fmt::println("velocity = [{}], relative_velocity = [{}]", toString(velocity.transpose()), toString(relativeVelocity.transpose()));
             assert(false);
         }
@@ -797,29 +1096,31 @@ namespace Sim{
 
         //fmt::println("INERTIA\n{}\n", toString(inertia));
 
-        StepData data = {
-            std::pair<std::string, double>{"Altitude", alt},
-            std::pair<std::string, double>{"Pressure", pres},
-            std::pair<std::string, double>{"Density", atmDens},
-            std::pair<std::string, double>{"Mass", m},
-            std::pair<std::string, double>{"g", g},
-            std::pair<std::string, double>{"CGx", (_rotmat.transpose()*rockCM).x()},
-            std::pair<std::string, double>{"Thrust", th.norm()},
-            std::pair<std::string, double>{"CN", cn},
-            std::pair<std::string, double>{"AoA", angleOfAttack/M_PI*180},
-            std::pair<std::string, double>{"M", mach},
-            std::pair<std::string, double>{"CPx", (_rotmat.transpose()*rockCP).x()},
-            std::pair<std::string, double>{"Yaw Damping", yawDampingCoeff},
-            std::pair<std::string, double>{"Pitch Damping", pitchDampingCoeff},
-            std::pair<std::string, double>{"Ixx", Ixx},
-            std::pair<std::string, double>{"Iyy", Iyy},
-            std::pair<std::string, double>{"Izz", Izz},
-            std::pair<std::string, double>{"ReL", reynL},
-            std::pair<std::string, double>{"Cdf", cdf},
-            std::pair<std::string, double>{"Cdp", cdp},
-            std::pair<std::string, double>{"Cdb", cdb},
-            std::pair<std::string, double>{"Cd", cd}
-        };
+        StepData data;
+        data[Telemetry::Altitude] = alt;
+        data[Telemetry::Pressure] = pres;
+        data[Telemetry::Density] = atmDens;
+        data[Telemetry::Mass] = m;
+        data[Telemetry::Gravity] = g;
+        data[Telemetry::CGx] = (_rotmat.transpose()*rockCM).x();
+        data[Telemetry::Thrust] = th.norm();
+        data[Telemetry::CN] = cn;
+        data[Telemetry::AoA] = angleOfAttack/M_PI*180;
+        data[Telemetry::Mach] = mach;
+        data[Telemetry::CPx] = (_rotmat.transpose()*rockCP).x();
+        data[Telemetry::YawDamping] = yawDampingCoeff;
+        data[Telemetry::PitchDamping] = pitchDampingCoeff;
+        data[Telemetry::Ixx] = Ixx;
+        data[Telemetry::Iyy] = Iyy;
+        data[Telemetry::Izz] = Izz;
+        data[Telemetry::ReL] = reynL;
+        data[Telemetry::Cdf] = cdf;
+        data[Telemetry::Cdp] = cdp;
+        data[Telemetry::Cdb] = cdb;
+        data[Telemetry::Cd] = cd;
+        data[Telemetry::DynamicPressure] = dynamicPressure;
+        data[Telemetry::Time] = time;
+        data[Telemetry::CompTime] = 0;
 
         //fmt::print("TIME {}, OUT [{}]\n\n", time, toString(res.transpose()));
         
@@ -836,8 +1137,12 @@ namespace Sim{
         return distToEarthSurf;
     }
 
-    Eigen::Vector3d Sim::wind(Eigen::Vector3d position) const {
-        return Eigen::Vector3d::Zero();
+    Eigen::Vector3d Sim::wind(double altitude, double time) const {
+        Eigen::Vector3d windVel = _windProfile ? _windProfile->at(altitude) : Eigen::Vector3d::Zero();
+        if(_turbulence){
+            windVel += _turbulence->at(time);
+        }
+        return windVel;
     }
 
     Eigen::Vector3d Sim::originToCenterOfEarth() const {
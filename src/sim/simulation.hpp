@@ -3,19 +3,83 @@
 
 #include "rocketInterface.hpp"
 #include "stateArray.hpp"
+#include "telemetry.hpp"
 #include "RealAtmos.hpp"
+#include "atmosTable.hpp"
+#include "massTable.hpp"
+#include "profiler.hpp"
+#include "events.hpp"
+#include "denseOutput.hpp"
+#include "history.hpp"
+#include "wind.hpp"
+#include "checkpoint.hpp"
 #include "nanValues.hpp"
+#include <array>
+#include <bitset>
 #include <memory>
+#include <optional>
 #include <vector>
 #include <Eigen/Dense>
 #include <filesystem>
+#include <random>
 
 namespace Sim{
 
     enum IntegrationStrats{
         EULER,
         RK4,
-        AB
+        AB, // fixed step adams bashforth moulton, RK4 steps until 3 steps of the same size are behind it
+        DP45, // adaptive dormand prince 5(4)
+        ABM // variable step, variable order adams bashforth moulton in nordsieck form
+    };
+
+    enum AttitudeRepresentations{
+        EULER_ANGLES, // Phi, Theta and Psi are integrated directly from dPhi, dTheta and dPsi
+        QUATERNION // the attitude is a quaternion driven by the body rates, with no trig per evaluation and no gimbal lock
+    };
+
+    /**
+     * @brief Headline results of a single call to Sim::solve
+     */
+    struct FlightSummary{
+        double apogee = 0;
+        double apogeeTime = 0;
+        double flightTime = 0;
+        double railExitTime = NAN_D; // NaN if the event did not occur
+        double burnoutTime = NAN_D;
+        int steps = 0;
+        // the kpis below are NaN unless selected with Sim::setKpis, maxima are taken over the ends of accepted steps
+        double maxMach = NAN_D;
+        double maxDynamicPressure = NAN_D; // pascals
+        double railExitVelocity = NAN_D; // meters/second
+        Eigen::Vector3d landingPosition = Eigen::Vector3d::Constant(NAN_D); // NaN unless the flight ended on the ground
+        bool stepLimited = false; // the flight was cut off at the step limit before landing, the values above only cover it up to there
+    };
+
+    namespace Kpis{
+        // flight summary values tracked during integration on top of the apogee, times and step count, which are always kept
+        enum Kpi {
+            MaxMach, MaxDynamicPressure, RailExitVelocity, LandingPosition, LAST
+        };
+
+        using KpiMask = std::bitset<LAST>;
+
+        inline KpiMask allKpis(){
+            return KpiMask().set();
+        }
+    }
+
+    /**
+     * @brief A single integration step along with what is needed to continue from it
+     */
+    struct StepResult{
+        double time;
+        StateArray state;
+        StepData data;
+        std::tuple<StateArray, StepData> endDat; // derivative at the new state, reused as the first stage of the next step
+        DenseOutput dense;
+        double error = 0; // scaled rms error estimate, the step meets the tolerances when this is at most 1
+        double nextStep = 0; // the step the controller proposes next
     };
 
     class Sim{
@@ -28,7 +92,69 @@ namespace Sim{
             RocketInterface* _rocket;
             Eigen::Matrix3d _rotmat; // the rotation matrix from the designs coords to the rockets coords
 
+            // each sim owns its generator so that sims can run concurrently and reproducibly
+            std::mt19937_64::result_type _seed = 69;
+            std::mt19937_64 _rng;
+            bool _verbose = true;
+            FlightSummary _summary;
+            EventLocator _events;
+
+            IntegrationStrats _integrator = RK4;
+            AttitudeRepresentations _attitudeRepresentation = EULER_ANGLES;
+            // with QUATERNION the Phi, Theta and Psi slots of the state hold the vector part of the rotation since this reference,
+            // which is folded back in before the rotation grows large so the scalar part is always the positive root
+            Eigen::Quaterniond _attitudeReference = Eigen::Quaterniond::Identity();
+            static constexpr double ATTITUDE_REBASE = 0.25; // squared norm of the vector part it is folded in at, 60 degrees
+
+            double _checkpointTime = NAN_D;
+            Events::FlightEvents _checkpointEvent = Events::LAST; // LAST for none
+            std::optional<Checkpoint> _checkpoint; // taken during the last solve or resume
+            // per component tolerances of the adaptive integrators, at these a typical flight's apogee is within millimetres of a
+            // tight solve while DP45 and ABM take a fraction of RK4's derivative evaluations, tighter ones can cost more than RK4
+            StateArray _rtol = StateArray::Constant(1e-4);
+            StateArray _atol = StateArray::Constant(1e-4);
+            // the adaptive integrators accept steps this small whatever their error, as a step across a switch in the forces
+            // can't meet the tolerances at any size
+            static constexpr double MIN_ADAPTIVE_STEP = 1e-3;
+            // step controller memory, reset at the start of each solve
+            double _lastError = 1e-4;
+            bool _lastRejected = false;
+
+            // adams state, the nordsieck vector holds [y, h*y', h^2*y''/2!, ..., h^q*y^(q)/q!] for the current step h and order q
+            static const int ABM_MAX_ORDER = 5;
+            std::array<StateArray, ABM_MAX_ORDER + 1> _nordsieck;
+            int _abmOrder = 1;
+            double _abmStep = 0;
+            int _abmStepsSinceChange = 0; // accepted steps since the step or order last changed
+            StateArray _abmLastCorrection = StateArray::Zero();
+            bool _abmRestart = true; // the history is rebuilt from a single derivative on the next step
+
+            // the derivatives at the start of the last 3 steps for the fixed step adams method, cleared at the start of each solve
+            // and at discontinuities, and only filled when it is selected
+            StepHistory<3> _history;
+            inline bool usesHistory() const {
+                return _integrator == AB;
+            }
+
+            // scaled rms norm of an error estimate using the per component tolerances
+            double errorNorm(const StateArray& err, const StateArray& y0, const StateArray& y1) const;
+            // rescales the nordsieck vector for a new step size
+            void rescaleNordsieck(double factor);
+
+            Telemetry::ChannelMask _channels = Telemetry::allChannels();
+            bool _recordTrajectory = false;
+            Trajectory _trajectory;
+
             RealAtmos::RealAtmos* _atmos;
+            std::shared_ptr<const RealAtmos::AtmosTable> _atmosTable = nullptr; // when set atmospheric properties are read from this instead of _atmos
+            std::shared_ptr<const WindProfile> _windProfile = nullptr; // still air when unset
+            TurbulenceSettings _turbulenceSettings;
+            std::shared_ptr<const Turbulence> _turbulence = nullptr; // generated at the start of each solve when enabled
+            bool _tabulateMass = true;
+            bool _summaryOnly = false;
+            Kpis::KpiMask _kpis = Kpis::allKpis();
+            Profiler _profiler; // only filled when built with FARSEER_PROFILE
+            std::shared_ptr<const MassTable> _massTable = nullptr; // built at the start of each solve when _tabulateMass is set
             Sim(RocketInterface* rocket, double timeStep, std::filesystem::path destination);
 
             //const Eigen::Array<double, 1, 6> RK_A = {0.0, 1.0/4, 3.0/8, 12.0/13, 1.0, 1.0/2 }; // fehlberg
@@ -59,11 +185,39 @@ namespace Sim{
             const Eigen::Array<double, 1, 7> RK_CH = {35.0/384, 0,  500.0/1113, 125.0/192,  -2187.0/6784,   11.0/84, 0.0};
             //const Eigen::Array<double, 1, 6> RK_CT = {-1.0/360, 0, 128.0/4275, 2197.0/75240, -1.0/50, -2.0/55};
             const Eigen::Array<double, 1, 7> RK_CT = Eigen::Array<double, 1, 7>{5179.0/57600, 	0.0, 	7571.0/16695,	393.0/640, 	-92097.0/339200, 	187.0/2100, 	1.0/40} - RK_CH;
+            // nordsieck correction vectors, row q is for a degree q history with an adams moulton corrector of order q+1
+            const Eigen::Array<double, 6, 6> ABM_L = {
+                {0,             0,  0,          0,          0,          0},
+                {1.0/2,         1,  0,          0,          0,          0},
+                {5.0/12,        1,  1.0/2,      0,          0,          0},
+                {3.0/8,         1,  3.0/4,      1.0/6,      0,          0},
+                {251.0/720,     1,  11.0/12,    1.0/3,      1.0/24,     0},
+                {95.0/288,      1,  25.0/24,    35.0/72,    5.0/48,     1.0/120}
+            };
+            // adams moulton error constants, the difference between the order q and q+1 correctors
+            const Eigen::Array<double, 1, 7> ABM_ERR = {0, 1.0/2, 1.0/12, 1.0/24, 19.0/720, 3.0/160, 863.0/60480};
+
+            // hairers continuous extension for dormand prince, gives the fifth dense output coefficient
+            const Eigen::Array<double, 1, 7> RK_D = {
+                -12715105075.0/11282082432, 0, 87487479700.0/32700410799, -10690763975.0/1880347072,
+                701980252875.0/199316789632, -1453857185.0/822651844, 69997945.0/29380423
+            };
 
 
         public:
             std::filesystem::path saveFile;
+            // solve stops after this many steps and marks the flight as step limited
+            static const int MAX_STEPS = 100000;
             static std::shared_ptr<Sim> create( RocketInterface* rocket, double timeStep, std::filesystem::path destination);
+
+            /**
+             * @brief The rotation taking a rocket's design coordinates into the sim's, so that rocketUp maps onto thisUp
+             * 
+             * @param rocketUp the rockets up vector
+             * @param thisUp the sims up vector
+             * @return Eigen::Matrix3d 
+             */
+            static Eigen::Matrix3d alignmentRotation(Eigen::Vector3d rocketUp, Eigen::Vector3d thisUp);
             // defining up
             inline Eigen::Vector3d thisWayUp() const { return Eigen::Vector3d{0,0,1}; }
 
@@ -92,6 +246,10 @@ namespace Sim{
                 return _rodLen;
             }
 
+            inline void setRodLen( double rodLen ) {
+                _rodLen = rodLen;
+            }
+
             inline const bool onRod() const {
                 return _onRod;
             }
@@ -100,9 +258,216 @@ namespace Sim{
                 _onRod = isOnRod;
             }
 
+            inline const std::mt19937_64::result_type seed() const {
+                return _seed;
+            }
+
+            // the generator is reseeded with this at the start of every solve
+            inline void setSeed( std::mt19937_64::result_type seed ) {
+                _seed = seed;
+            }
+
+            inline const bool verbose() const {
+                return _verbose;
+            }
+
+            // disables progress printing, used when running many sims at once
+            inline void setVerbose( bool verbose ) {
+                _verbose = verbose;
+            }
+
+            inline std::shared_ptr<const RealAtmos::AtmosTable> atmosTable() const {
+                return _atmosTable;
+            }
+
+            // flies through a precomputed table instead of the analytic atmosphere, nullptr returns to the analytic model
+            inline void setAtmosTable( std::shared_ptr<const RealAtmos::AtmosTable> table ) {
+                _atmosTable = table;
+            }
+
+            inline std::shared_ptr<const WindProfile> windProfile() const {
+                return _windProfile;
+            }
+
+            // the mean wind flown through, nullptr for still air
+            inline void setWindProfile( std::shared_ptr<const WindProfile> profile ) {
+                _windProfile = profile;
+            }
+
+            inline const TurbulenceSettings& turbulenceSettings() const {
+                return _turbulenceSettings;
+            }
+
+            // gusts over the mean wind, each solve generates its own realization from the seed
+            inline void setTurbulenceSettings( TurbulenceSettings settings ) {
+                _turbulenceSettings = settings;
+            }
+
+            // the gusts of the last solve, nullptr if turbulence is off
+            inline std::shared_ptr<const Turbulence> turbulence() const {
+                return _turbulence;
+            }
+
+            inline const bool tabulateMass() const {
+                return _tabulateMass;
+            }
+
+            // samples the rockets mass properties over the burn once per solve instead of every stage, on by default
+            inline void setTabulateMass( bool tabulate ) {
+                _tabulateMass = tabulate;
+            }
+
+            inline std::shared_ptr<const MassTable> massTable() const {
+                return _massTable;
+            }
+
+            inline const bool summaryOnly() const {
+                return _summaryOnly;
+            }
+
+            // only the flight summary is kept, no file is written and no trajectory is recorded whatever the other settings are
+            inline void setSummaryOnly( bool summaryOnly ) {
+                _summaryOnly = summaryOnly;
+            }
+
+            inline const Kpis::KpiMask& kpis() const {
+                return _kpis;
+            }
+
+            // selects the kpis tracked in the flight summary, all by default
+            inline void setKpis( Kpis::KpiMask kpis ) {
+                _kpis = kpis;
+            }
+
+            // phase timings of the last solve, empty unless built with FARSEER_PROFILE
+            inline const Profiler& profiler() const {
+                return _profiler;
+            }
+
+            inline const double checkpointTime() const {
+                return _checkpointTime;
+            }
+
+            // solve takes a checkpoint at the end of the first step reaching this time, NaN for none
+            inline void setCheckpointTime( double time ) {
+                _checkpointTime = time;
+            }
+
+            inline const Events::FlightEvents checkpointEvent() const {
+                return _checkpointEvent;
+            }
+
+            // solve takes a checkpoint at the end of the step this event fires in, Events::LAST for none
+            inline void setCheckpointEvent( Events::FlightEvents event ) {
+                _checkpointEvent = event;
+            }
+
+            // the checkpoint taken during the last solve or resume, if one was
+            inline const std::optional<Checkpoint>& checkpoint() const {
+                return _checkpoint;
+            }
+
+            // results of the last solve
+            inline const FlightSummary& summary() const {
+                return _summary;
+            }
+
+            inline const IntegrationStrats integrator() const {
+                return _integrator;
+            }
+
+            // the method solve steps with, only RK4, AB, DP45 and ABM are supported
+            void setIntegrator( IntegrationStrats integrator );
+
+            inline const AttitudeRepresentations attitudeRepresentation() const {
+                return _attitudeRepresentation;
+            }
+
+            /**
+             * @brief How solve integrates the attitude, states passed in and out of solve always hold euler angles
+             * with QUATERNION the angles given back are wrapped and dPhi, dTheta and dPsi are the body rates about x, y and z
+             * rather than the rates of the angles, in the initial conditions, results, trajectory and checkpoints alike,
+             * and the output file names those columns wx, wy and wz. they are not converted as the angle rates are singular
+             * at a pitch of +-pi/2
+             */
+            inline void setAttitudeRepresentation( AttitudeRepresentations representation ) {
+                _attitudeRepresentation = representation;
+            }
+
+            inline const StateArray& rtol() const {
+                return _rtol;
+            }
+
+            inline const StateArray& atol() const {
+                return _atol;
+            }
+
+            // tolerances for the adaptive integrator, a component's error is scaled by atol + rtol*|state|
+            inline void setTolerances( const StateArray& rtol, const StateArray& atol ) {
+                _rtol = rtol;
+                _atol = atol;
+            }
+
+            // the events located during the last solve
+            inline const EventLocator& events() const {
+                return _events;
+            }
+
+            inline const Telemetry::ChannelMask& channels() const {
+                return _channels;
+            }
+
+            // the telemetry channels written out and recorded for each step
+            inline void setChannels( Telemetry::ChannelMask channels ) {
+                _channels = channels;
+            }
+
+            inline const bool recordTrajectory() const {
+                return _recordTrajectory;
+            }
+
+            // keeps the selected channels of every step of the next solve in memory, off by default
+            inline void setRecordTrajectory( bool record ) {
+                _recordTrajectory = record;
+            }
+
+            // the trajectory recorded by the last solve, empty unless recordTrajectory is set
+            inline const Trajectory& trajectory() const {
+                return _trajectory;
+            }
+
             // sim functions
+            /**
+             * @brief Integrates the flight from the initial conditions until landing, results are written to saveFile unless it is empty
+             * 
+             * @param initialConditions the state of the rocket on the pad
+             * @return StateArray the state at termination
+             */
             StateArray solve( StateArray initialConditions );
 
+            /**
+             * @brief Carries a flight on from a checkpoint until landing, the rocket and settings may differ from the sim that took it
+             * such as a recovery change or a dispersion that only acts later, the integrator and attitude representation are taken
+             * from the checkpoint and output starts at the checkpoint
+             *
+             * the checkpoint's derivative is only reused when resuming with the rocket that took it and its generator,
+             * otherwise it is recomputed with this sims rocket and generator and the multistep memory is restarted
+             *
+             * @param checkpoint where to start, from checkpoint() of this or another sim
+             * @param reseed draws from this sims seed rather than carrying on the checkpoints generator, so forks differ
+             * @return StateArray the state at termination
+             */
+            StateArray resume( const Checkpoint& checkpoint, bool reseed = false );
+
+            /**
+             * @brief The state of a checkpoint with its attitude as euler angles, as solve takes and returns it
+             * Checkpoint::state is in the layout it was integrated in, which for QUATERNION is relative to its reference attitude
+             *
+             * @param checkpoint
+             * @return StateArray
+             */
+            static StateArray externalState( const Checkpoint& checkpoint );
+
             /**
              * @brief Calculates the derivative of all the state vector fields
              * 
@@ -124,38 +489,94 @@ namespace Sim{
 
             static const std::tuple<StateArray, StepData> defK1arg;
 
-            // using defaults from scipy ode
-            std::tuple<double, StateArray, StepData> adaptiveRKIntegrate( const double time, const double step, const StateArray state, const double rtol = 1e-3, const double atol = 1e-6);
+            /**
+             * @brief Takes one dormand prince step of the given size with no error control
+             * 
+             * @param time time of the inputted state
+             * @param step step size
+             * @param state the state at the given time
+             * @param k1Dat the derivative at the given state, the last stage of the previous step
+             * @return StepResult with the error estimate filled in
+             */
+            StepResult DP45Step( const double time, const double step, const StateArray* state, const std::tuple<StateArray, StepData>* k1Dat);
+
+            /**
+             * @brief Takes an adaptive dormand prince step, retrying with smaller steps until the error is within the tolerances
+             * or the step is down to MIN_ADAPTIVE_STEP, which is kept whatever its error
+             * the step size is chosen by a PI controller whose memory is kept between calls
+             * 
+             * @param time time of the inputted state
+             * @param step the step to try first
+             * @param state the state at the given time
+             * @param k1Dat the derivative at the given state, the last stage of the previous step
+             * @return StepResult the accepted step, nextStep holds the proposed size of the next one
+             */
+            StepResult DP45Integrate( const double time, const double step, const StateArray* state, const std::tuple<StateArray, StepData>* k1Dat);
+
+            /**
+             * @brief Takes a predict, evaluate, correct, evaluate adams step, 2 derivative evaluations when accepted
+             * the step size and order change between steps and the history is kept as a nordsieck vector
+             * so nothing has to be recomputed when the step changes, the history is rebuilt after events
+             * steps are never shorter than MIN_ADAPTIVE_STEP, one that misses the tolerances at that size is kept and the history restarted
+             * 
+             * @param time time of the inputted state
+             * @param step the step to start with after a restart, otherwise the step is chosen from the history
+             * @param state the state at the given time
+             * @param k1Dat the derivative at the given state, the final evaluation of the previous step
+             * @return StepResult the accepted step, nextStep holds the proposed size of the next one
+             */
+            StepResult ABMIntegrate( const double time, const double step, const StateArray* state, const std::tuple<StateArray, StepData>* k1Dat);
             
 
             std::tuple<double, StateArray, StepData> RK4Integrate( const double time, const double step, const StateArray* state, const std::tuple<StateArray, StepData>* inK1Dat = &defK1arg);
 
             double selectTimeStep(const StateArray* state, const StateArray* k1, const double currStep) const;
 
+            // the solve loop, shared by solve and resume, first is the initial row of the output
+            StateArray fly( const Checkpoint& start, const StateArray& firstState, const StepData& firstData );
+            void resetEvents();
+            // the sims own part of a checkpoint, the flags, generator and integrator memory
+            void saveSolverState( Checkpoint& checkpoint ) const;
+            void restoreSolverState( const Checkpoint& checkpoint );
+
+            // the body to global rotation of a state in the layout solve integrates
+            Eigen::Matrix3d rotation(const StateArray& state) const;
+            // the body to global rotation of a quaternion state held relative to reference
+            static Eigen::Matrix3d quaternionRotation(const StateArray& state, const Eigen::Quaterniond& reference);
+            // a quaternion state with its attitude as euler angles
+            static StateArray quaternionToEuler(const StateArray& state, const Eigen::Quaterniond& reference);
+            // euler angle initial conditions in the layout solve integrates, resets the reference attitude
+            StateArray internalState(const StateArray& state);
+            // a state solve integrates with its attitude as euler angles
+            StateArray externalState(const StateArray& state) const;
+            // folds the rotation held in a quaternion state into the reference attitude once it is large, true if it was
+            bool rebaseAttitude(StateArray& state);
+
+            // takes a single step of the given size with the selected integrator, filling in the end derivative and dense output
+            StepResult takeStep( const double time, const double step, const StateArray* state, const std::tuple<StateArray, StepData>* k1Dat);
+
+            // fourth order adams bashforth predictor with one adams moulton correction, RK4 until the history holds 3 steps
             std::tuple<double, StateArray, StepData> AB4Integrate(
-                const double time, const double step, const StateArray* state, const std::vector<StateArray>* diffs, const std::vector<StepData>* stepData,
-                const std::tuple<StateArray, StepData>* inK1Dat = &defK1arg
-                );
-            
-            std::tuple<double, StateArray, StepData> AB22Integrate(
-                const double time, const double step, const StateArray* state, const std::vector<StateArray>* diffs,
-                const std::vector<StepData>* stepData, const std::tuple<StateArray, StepData>* inK1Dat = &defK1arg
-                );
-            
-            std::tuple<double, StateArray, StepData> AB44Integrate(
-                const double time, const double step, const StateArray* state, const std::vector<StateArray>* diffs,
-                const std::vector<StepData>* stepData, const std::tuple<StateArray, StepData>* inK1Dat = &defK1arg
+                const double time, const double step, const StateArray* state, HistoryView history,
+                const std::tuple<StateArray, StepData>* k1Dat
                 );
 
             std::tuple<double, StateArray, StepData> ORKIntegrate( const double time, const double step, const StateArray* state, const StateArray* lastState);
 
-            std::tuple<double, StateArray, StepData> ABRKIntegrate(
-                const double time, const double step, const StateArray* state, const StateArray* lastState,
-                const std::vector<StateArray>* diffs, const std::vector<StepData>* stepData, const std::vector<double>* steps
+            /**
+             * @brief A fixed step adams bashforth moulton step once the history holds 3 steps of this size, otherwise an RK4 step
+             *
+             * @param step the step to take, already chosen by selectTimeStep
+             * @param k1Dat the derivative at the start of the step
+             * @param history the accepted steps before this one
+             * @return StepResult the step with its end derivative and dense output, nextStep is the step taken
+             */
+            StepResult ABRKIntegrate(
+                const double time, const double step, const StateArray* state, const std::tuple<StateArray, StepData>* k1Dat, HistoryView history
                 );
 
-            // wind func
-            Eigen::Vector3d wind(Eigen::Vector3d position) const;
+            // wind velocity in the global frame, the mean wind at the altitude plus the gust at the time
+            Eigen::Vector3d wind(double altitude, double time) const;
 
             // helper functions
             Eigen::Vector3d originToCenterOfEarth() const;
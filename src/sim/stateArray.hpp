@@ -8,6 +8,8 @@
 #include <unordered_map>
 
 namespace Sim{
+    // dPhi, dTheta and dPsi are the rates of Phi, Theta and Psi when the sim integrates euler angles,
+    // and the body rates about x, y and z when it integrates a quaternion, see Sim::setAttitudeRepresentation
     enum StateMappings {
         Xp, Xv, Yp, Yv, Zp, Zv, Phi, dPhi, Theta, dTheta, Psi, dPsi, LAST
     };
@@ -22,8 +24,6 @@ namespace Sim{
     const Eigen::Vector3d stateArrayPosition(StateArray state);
     const Eigen::Vector3d stateArrayAngVelocity(StateArray state);
     const Eigen::Vector3d stateArrayOrientation(StateArray state);
-    
-    using StepData = std::unordered_map<std::string, double>;
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "telemetry.hpp"
+#include <fmt/core.h>
+#include <stdexcept>
+
+namespace Sim{
+
+    namespace Telemetry{
+        ChannelMask allChannels(){
+            return ChannelMask().set();
+        }
+
+        std::vector<Channels> selected(const ChannelMask& channels){
+            std::vector<Channels> res = {};
+            for(int i = 0; i < LAST; i++){
+                if(channels.test(i)){
+                    res.push_back((Channels)i);
+                }
+            }
+            return res;
+        }
+    }
+
+    Trajectory::Trajectory(Telemetry::ChannelMask channels){
+        _channels = channels;
+    }
+
+    void Trajectory::reserve(size_t steps){
+        for(auto s = _states.begin(); s != _states.end(); s++){
+            s->reserve(steps);
+        }
+        for(int i = 0; i < Telemetry::LAST; i++){
+            if(_channels.test(i)){
+                _data[i].reserve(steps);
+            }
+        }
+    }
+
+    void Trajectory::clear(){
+        for(auto s = _states.begin(); s != _states.end(); s++){
+            s->clear();
+        }
+        for(auto d = _data.begin(); d != _data.end(); d++){
+            d->clear();
+        }
+    }
+
+    void Trajectory::push(const StateArray& state, const StepData& data){
+        for(int i = 0; i < StateMappings::LAST; i++){
+            _states[i].push_back(state[i]);
+        }
+        for(int i = 0; i < Telemetry::LAST; i++){
+            if(_channels.test(i)){
+                _data[i].push_back(data[i]);
+            }
+        }
+    }
+
+    Eigen::Map<const Eigen::ArrayXd> Trajectory::state(StateMappings component) const {
+        const auto& col = _states[component];
+        return Eigen::Map<const Eigen::ArrayXd>(col.data(), col.size());
+    }
+
+    Eigen::Map<const Eigen::ArrayXd> Trajectory::channel(Telemetry::Channels channel) const {
+        if(!_channels.test(channel)){
+            throw std::out_of_range(fmt::format("channel \"{}\" was not recorded", Telemetry::NAMES[channel]));
+        }
+        const auto& col = _data[channel];
+        return Eigen::Map<const Eigen::ArrayXd>(col.data(), col.size());
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include "stateArray.hpp"
+#include <array>
+#include <bitset>
+#include <vector>
+#include <Eigen/Dense>
+
+namespace Sim{
+
+    namespace Telemetry{
+        // fixed ids of every channel recorded alongside the state, these index into StepData
+        enum Channels {
+            Altitude, Pressure, Density, Mass, Gravity, CGx, Thrust, CN, AoA, Mach, CPx, YawDamping, PitchDamping,
+            Ixx, Iyy, Izz, ReL, Cdf, Cdp, Cdb, Cd, DynamicPressure, Time, CompTime, LAST
+        };
+
+        // column names used in output files, indexed by channel
+        constexpr std::array<const char*, LAST> NAMES = {
+            "Altitude", "Pressure", "Density", "Mass", "g", "CGx", "Thrust", "CN", "AoA", "M", "CPx", "Yaw Damping", "Pitch Damping",
+            "Ixx", "Iyy", "Izz", "ReL", "Cdf", "Cdp", "Cdb", "Cd", "q", "t", "ctime"
+        };
+
+        // selects which channels are kept for a run
+        using ChannelMask = std::bitset<LAST>;
+
+        ChannelMask allChannels();
+
+        // the selected channels in id order
+        std::vector<Channels> selected(const ChannelMask& channels);
+    }
+
+    // one record per step, indexed by Telemetry::Channels
+    using StepData = Eigen::Array<double, Telemetry::LAST, 1>;
+
+    /**
+     * @brief Column store of a whole flight, each state component and selected channel is kept in its own contiguous array
+     * so that columns can be handed to analysis code without copying
+     */
+    class Trajectory{
+        private:
+            Telemetry::ChannelMask _channels;
+            std::array<std::vector<double>, StateMappings::LAST> _states;
+            std::array<std::vector<double>, Telemetry::LAST> _data;
+
+        public:
+            Trajectory(Telemetry::ChannelMask channels = Telemetry::allChannels());
+
+            inline const Telemetry::ChannelMask& channels() const {
+                return _channels;
+            }
+
+            inline size_t size() const {
+                return _states[0].size();
+            }
+
+            void reserve(size_t steps);
+            void clear();
+            void push(const StateArray& state, const StepData& data);
+
+            // a view of one state component over the whole flight
+            Eigen::Map<const Eigen::ArrayXd> state(StateMappings component) const;
+            // a view of one channel over the whole flight, throws if the channel was not selected
+            Eigen::Map<const Eigen::ArrayXd> channel(Telemetry::Channels channel) const;
+    };
+}
+
+#endif
@@ -0,0 +1,124 @@
+#include "threadPool.hpp"
+
+namespace Sim{
+
+    // the pool and queue index of the worker running on this thread, used to keep nested submissions local
+    static thread_local ThreadPool* currentPool = nullptr;
+    static thread_local size_t currentWorker = 0;
+
+    ThreadPool::ThreadPool(size_t threads){
+        if(threads == 0){
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for(size_t i = 0; i < threads; i++){
+            _queues.push_back(std::make_unique<WorkQueue>());
+        }
+        for(size_t i = 0; i < threads; i++){
+            _threads.emplace_back([this, i](){ workerLoop(i); });
+        }
+    }
+
+    ThreadPool::~ThreadPool(){
+        {
+            std::lock_guard<std::mutex> lock(_sleepMutex);
+            _stop = true;
+        }
+        _sleepCv.notify_all();
+        for(auto t = _threads.begin(); t != _threads.end(); t++){
+            t->join();
+        }
+    }
+
+    void ThreadPool::submit(std::function<void()> task){
+        size_t queue;
+        if(currentPool == this){
+            queue = currentWorker;
+        } else {
+            queue = _nextQueue.fetch_add(1) % _queues.size();
+        }
+        _pending++;
+        // counted before the push so that a worker can never take the task before it is counted
+        _queued++;
+        {
+            std::lock_guard<std::mutex> lock(_queues[queue]->mutex);
+            _queues[queue]->tasks.push_back(std::move(task));
+        }
+        // a worker counts itself as sleeping before it checks _queued, so either it sees this task or it is seen here,
+        // taking the lock means it is already waiting when notified
+        if(_sleeping > 0){
+            { std::lock_guard<std::mutex> lock(_sleepMutex); }
+            _sleepCv.notify_one();
+        }
+    }
+
+    void ThreadPool::wait(){
+        {
+            std::unique_lock<std::mutex> lock(_sleepMutex);
+            _doneCv.wait(lock, [this](){ return _pending == 0; });
+        }
+        std::lock_guard<std::mutex> lock(_errorMutex);
+        if(_error != nullptr){
+            auto err = _error;
+            _error = nullptr;
+            std::rethrow_exception(err);
+        }
+    }
+
+    bool ThreadPool::popTask(size_t worker, std::function<void()>& task){
+        // own work is taken from the back so that recently queued (cache warm) tasks run first
+        {
+            auto& own = *_queues[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if(!own.tasks.empty()){
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        // stealing from the front of the other queues, starting with the neighbour to spread contention
+        for(size_t i = 1; i < _queues.size(); i++){
+            auto& victim = *_queues[(worker + i) % _queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if(!victim.tasks.empty()){
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void ThreadPool::workerLoop(size_t worker){
+        currentPool = this;
+        currentWorker = worker;
+        while(true){
+            std::function<void()> task;
+            if(!popTask(worker, task)){
+                // nothing to take, a task counted but not yet pushed is picked up on the next pass
+                std::unique_lock<std::mutex> lock(_sleepMutex);
+                _sleeping++;
+                _sleepCv.wait(lock, [this](){ return _stop || _queued > 0; });
+                _sleeping--;
+                if(_stop && _queued == 0){
+                    return;
+                }
+                continue;
+            }
+            _queued--;
+
+            try{
+                task();
+            } catch(...) {
+                std::lock_guard<std::mutex> lock(_errorMutex);
+                if(_error == nullptr){
+                    _error = std::current_exception();
+                }
+            }
+
+            if(--_pending == 0){
+                std::lock_guard<std::mutex> lock(_sleepMutex);
+                _doneCv.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Sim{
+
+    /**
+     * @brief Work stealing thread pool
+     * each worker owns a deque of tasks, it pops its own work from the back and steals from the front of the other workers
+     * when it runs dry, this keeps every core busy when tasks have very different run times
+     */
+    class ThreadPool{
+        private:
+            struct WorkQueue{
+                std::mutex mutex;
+                std::deque<std::function<void()>> tasks;
+            };
+
+            std::vector<std::unique_ptr<WorkQueue>> _queues;
+            std::vector<std::thread> _threads;
+
+            // only taken by workers going to sleep and by whoever wakes them, never on the way to a task
+            std::mutex _sleepMutex;
+            std::condition_variable _sleepCv; // idle workers wait on this for new tasks
+            std::condition_variable _doneCv; // wait() waits on this for all tasks to finish
+            std::atomic<size_t> _queued = 0; // tasks sitting in queues, counted before they are pushed
+            std::atomic<size_t> _sleeping = 0; // workers waiting on _sleepCv
+            std::atomic<size_t> _pending = 0; // tasks submitted but not yet finished
+            std::atomic<size_t> _nextQueue = 0;
+            bool _stop = false;
+
+            std::mutex _errorMutex;
+            std::exception_ptr _error = nullptr;
+
+            bool popTask(size_t worker, std::function<void()>& task);
+            void workerLoop(size_t worker);
+
+        public:
+            /**
+             * @brief Creates the pool and starts its workers
+             *
+             * @param threads number of workers, 0 uses one per hardware thread
+             */
+            ThreadPool(size_t threads = 0);
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool&) = delete;
+            void operator=(const ThreadPool&) = delete;
+
+            inline size_t size() const {
+                return _threads.size();
+            }
+
+            /**
+             * @brief Queues a task, tasks submitted from inside a worker go onto that workers queue
+             *
+             * @param task
+             */
+            void submit(std::function<void()> task);
+
+            /**
+             * @brief Blocks until every submitted task has finished, rethrows the first exception thrown by a task
+             */
+            void wait();
+    };
+}
+
+#endif
@@ -0,0 +1,128 @@
+#include "trajectoryWriter.hpp"
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <iterator>
+#include <stdexcept>
+
+namespace Sim{
+
+    static const char* STATE_HEADER = "Xp, Xv, Yp, Yv, Zp, Zv, Phi, dPhi, Theta, dTheta, Psi, dPsi"; //dont need to include LAST
+    static const char* BODY_RATE_STATE_HEADER = "Xp, Xv, Yp, Yv, Zp, Zv, Phi, wx, Theta, wy, Psi, wz";
+    static const size_t FLUSH_SIZE = 1 << 16;
+
+    TrajectoryWriter::TrajectoryWriter(std::filesystem::path path, Telemetry::ChannelMask channels, bool bodyRates, size_t capacity){
+        _file = std::fopen(path.string().c_str(), "w");
+        if(_file == nullptr){
+            throw std::runtime_error(fmt::format("could not open \"{}\" for writing", path.string()));
+        }
+        _columns = Telemetry::selected(channels);
+        _ring = std::vector<Row>(std::max<size_t>(capacity, 1), Row{ StateArray::Zero(), StepData::Zero() });
+
+        fmt::memory_buffer header;
+        fmt::format_to(std::back_inserter(header), "{}", bodyRates ? BODY_RATE_STATE_HEADER : STATE_HEADER);
+        for(auto c = _columns.cbegin(); c != _columns.cend(); c++){
+            fmt::format_to(std::back_inserter(header), ", {}", Telemetry::NAMES[*c]);
+        }
+        header.push_back('\n');
+        if(std::fwrite(header.data(), 1, header.size(), _file) != header.size()){
+            std::fclose(_file);
+            throw std::runtime_error(fmt::format("could not write the header to \"{}\"", path.string()));
+        }
+
+        _thread = std::thread([this](){ writerLoop(); });
+    }
+
+    TrajectoryWriter::~TrajectoryWriter(){
+        try{
+            close();
+        }catch(const std::runtime_error&){
+            // nothing can be done about a failed write here, call close first to see it
+        }
+    }
+
+    void TrajectoryWriter::push(const StateArray& state, const StepData& data){
+        std::unique_lock<std::mutex> lock(_mutex);
+        _notFull.wait(lock, [this](){ return _count < _ring.size(); });
+        // copying into the preallocated slot so a push never allocates
+        Row& row = _ring[(_head + _count) % _ring.size()];
+        row.state = state;
+        row.data = data;
+        _count++;
+        lock.unlock();
+        _notEmpty.notify_one();
+    }
+
+    void TrajectoryWriter::close(){
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if(_closed){
+                return;
+            }
+            _closed = true;
+        }
+        _notEmpty.notify_one();
+        _thread.join();
+        const bool closeFailed = std::fclose(_file) != 0;
+        _file = nullptr;
+        if(!_error.empty()){
+            throw std::runtime_error(_error);
+        }
+        if(closeFailed){
+            throw std::runtime_error("could not close the trajectory file");
+        }
+    }
+
+    void TrajectoryWriter::writerLoop(){
+        // after a failed write the rows are still taken off the ring so push never blocks, they are just not written
+        auto flush = [this](fmt::memory_buffer& buf){
+            if(_error.empty() && std::fwrite(buf.data(), 1, buf.size(), _file) != buf.size()){
+                _error = "could not write to the trajectory file";
+            }
+            buf.clear();
+        };
+
+        fmt::memory_buffer buf;
+        std::vector<Row> batch;
+        batch.reserve(_ring.size());
+        while(true){
+            size_t taken = 0;
+            bool closed;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _notEmpty.wait(lock, [this](){ return _count > 0 || _closed; });
+                // taking everything queued in one go so the producer is only held up for the copy
+                taken = _count;
+                if(batch.size() < taken){
+                    batch.resize(taken);
+                }
+                for(size_t i = 0; i < taken; i++){
+                    batch[i] = _ring[(_head + i) % _ring.size()];
+                }
+                _head = (_head + taken) % _ring.size();
+                _count = 0;
+                closed = _closed;
+            }
+            _notFull.notify_one();
+
+            for(size_t i = 0; i < taken; i++){
+                const Row& row = batch[i];
+                auto out = std::back_inserter(buf);
+                for(int j = 0; j < StateMappings::LAST; j++){
+                    out = j == 0 ? fmt::format_to(out, "{}", row.state[j]) : fmt::format_to(out, ", {}", row.state[j]);
+                }
+                for(auto c = _columns.cbegin(); c != _columns.cend(); c++){
+                    out = fmt::format_to(out, ", {}", row.data[*c]);
+                }
+                buf.push_back('\n');
+                if(buf.size() >= FLUSH_SIZE){
+                    flush(buf);
+                }
+            }
+
+            if(closed && taken == 0){
+                break;
+            }
+        }
+        flush(buf);
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef TRAJECTORY_WRITER_H_
+#define TRAJECTORY_WRITER_H_
+
+#include "stateArray.hpp"
+#include "telemetry.hpp"
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Sim{
+
+    /**
+     * @brief Streams accepted steps to a CSV file from a background thread
+     * rows are handed over through a fixed size ring, push only blocks if the writer falls a full ring behind,
+     * so memory use does not grow with the length of the flight and formatting overlaps with integration
+     */
+    class TrajectoryWriter{
+        private:
+            struct Row{
+                StateArray state;
+                StepData data;
+            };
+
+            std::FILE* _file = nullptr;
+            std::vector<Telemetry::Channels> _columns;
+
+            // bounded queue of rows, the slots are allocated once up front
+            std::vector<Row> _ring;
+            size_t _head = 0; // next row to be written out
+            size_t _count = 0; // rows waiting to be written
+            bool _closed = false;
+            std::string _error; // set by the writer thread when a write fails, raised from close
+
+            std::mutex _mutex;
+            std::condition_variable _notFull;
+            std::condition_variable _notEmpty;
+            std::thread _thread;
+
+            void writerLoop();
+
+        public:
+            /**
+             * @brief Opens the file, writes the header and starts the writer thread
+             *
+             * @param path file to write, truncated if it exists
+             * @param channels the step data channels written after the state, in channel id order
+             * @param bodyRates the rate columns hold body rates rather than euler angle rates, see Sim::setAttitudeRepresentation
+             * @param capacity number of rows that can be queued before push blocks
+             */
+            TrajectoryWriter(std::filesystem::path path, Telemetry::ChannelMask channels, bool bodyRates = false, size_t capacity = 4096);
+            ~TrajectoryWriter();
+
+            TrajectoryWriter(const TrajectoryWriter&) = delete;
+            void operator=(const TrajectoryWriter&) = delete;
+
+            inline const std::vector<Telemetry::Channels>& columns() const {
+                return _columns;
+            }
+
+            /**
+             * @brief Queues a row
+             *
+             * @param state
+             * @param data
+             */
+            void push(const StateArray& state, const StepData& data);
+
+            /**
+             * @brief Writes out everything queued, closes the file and stops the writer thread, called by the destructor
+             * throws std::runtime_error if any of the file could not be written, the destructor drops the error
+             */
+            void close();
+    };
+}
+
+#endif
@@ -0,0 +1,115 @@
+#include "wind.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace Sim{
+
+    WindProfile::WindProfile(const std::vector<double>& altitudes, const std::vector<Eigen::Vector3d>& velocities, double spacing){
+        _zMin = altitudes.front();
+        _spacing = spacing;
+        _invSpacing = 1/spacing;
+        const Eigen::Index n = static_cast<Eigen::Index>(std::ceil((altitudes.back() - altitudes.front())/spacing)) + 1;
+        _velocities.resize(3, n);
+
+        // walking the layers alongside the grid as both are sorted
+        size_t layer = 0;
+        for(Eigen::Index i = 0; i < n; i++){
+            const double z = std::min(_zMin + i*_spacing, altitudes.back());
+            while(layer + 2 < altitudes.size() && altitudes[layer + 1] < z){
+                layer++;
+            }
+            if(altitudes.size() == 1){
+                _velocities.col(i) = velocities.front();
+                continue;
+            }
+            const double t = (z - altitudes[layer])/(altitudes[layer + 1] - altitudes[layer]);
+            _velocities.col(i) = (1 - t)*velocities[layer] + t*velocities[layer + 1];
+        }
+    }
+
+    std::shared_ptr<const WindProfile> WindProfile::create(
+        const std::vector<double>& altitudes, const std::vector<Eigen::Vector3d>& velocities, double spacing
+        ){
+        if(altitudes.empty() || altitudes.size() != velocities.size()){
+            throw std::invalid_argument("a wind profile needs one velocity per altitude");
+        }
+        if(!(spacing > 0)){
+            throw std::invalid_argument("wind profile spacing must be positive");
+        }
+        for(size_t i = 1; i < altitudes.size(); i++){
+            if(!(altitudes[i] > altitudes[i - 1])){
+                throw std::invalid_argument("wind profile altitudes must be strictly increasing");
+            }
+        }
+        return std::shared_ptr<const WindProfile>(new WindProfile(altitudes, velocities, spacing));
+    }
+
+    std::shared_ptr<const WindProfile> WindProfile::constant(const Eigen::Vector3d& velocity){
+        return create({0}, {velocity});
+    }
+
+    Eigen::Vector3d WindProfile::at(double altitude) const {
+        const Eigen::Index last = _velocities.cols() - 1;
+        const double x = (altitude - _zMin)*_invSpacing;
+        if(!(x > 0)){
+            return _velocities.col(0);
+        }
+        if(x >= last){
+            return _velocities.col(last);
+        }
+        const Eigen::Index i = static_cast<Eigen::Index>(x);
+        const double t = x - i;
+        return (1 - t)*_velocities.col(i) + t*_velocities.col(i + 1);
+    }
+
+    Turbulence::Turbulence(const TurbulenceSettings& settings, std::mt19937_64& rng){
+        _interval = settings.sampleInterval;
+        _invInterval = 1/settings.sampleInterval;
+        const Eigen::Index n = static_cast<Eigen::Index>(std::ceil(settings.duration/settings.sampleInterval)) + 1;
+        _gusts.resize(3, n);
+
+        // each axis is x[k+1] = a*x[k] + sigma*sqrt(1 - a^2)*w[k], which keeps the rms at sigma for any sample interval
+        const Eigen::Array3d a = (-settings.airspeed*settings.sampleInterval/settings.lengthScale.array()).exp();
+        const Eigen::Array3d gain = settings.intensity.array()*(1 - a.square()).sqrt();
+        std::normal_distribution<double> noise(0, 1);
+
+        Eigen::Array3d gust;
+        for(int axis = 0; axis < 3; axis++){
+            // starting from the stationary distribution so there is no run in
+            gust[axis] = settings.intensity[axis]*noise(rng);
+        }
+        _gusts.col(0) = gust.matrix();
+        for(Eigen::Index k = 1; k < n; k++){
+            for(int axis = 0; axis < 3; axis++){
+                gust[axis] = a[axis]*gust[axis] + gain[axis]*noise(rng);
+            }
+            _gusts.col(k) = gust.matrix();
+        }
+    }
+
+    std::shared_ptr<const Turbulence> Turbulence::generate(const TurbulenceSettings& settings, std::mt19937_64::result_type seed){
+        if(!(settings.sampleInterval > 0) || !(settings.duration > 0) || !(settings.airspeed > 0)){
+            throw std::invalid_argument("turbulence needs a positive sample interval, duration and airspeed");
+        }
+        if(!(settings.lengthScale.array() > 0).all() || (settings.intensity.array() < 0).any()){
+            throw std::invalid_argument("turbulence needs positive length scales and non negative intensities");
+        }
+        std::mt19937_64 rng(seed);
+        return std::shared_ptr<const Turbulence>(new Turbulence(settings, rng));
+    }
+
+    Eigen::Vector3d Turbulence::at(double time) const {
+        const Eigen::Index last = _gusts.cols() - 1;
+        const double x = time*_invInterval;
+        if(!(x > 0)){
+            return _gusts.col(0);
+        }
+        if(x >= last){
+            return _gusts.col(last);
+        }
+        const Eigen::Index i = static_cast<Eigen::Index>(x);
+        const double t = x - i;
+        return (1 - t)*_gusts.col(i) + t*_gusts.col(i + 1);
+    }
+}
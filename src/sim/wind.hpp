@@ -0,0 +1,89 @@
+#ifndef WIND_H_
+#define WIND_H_
+
+#include <memory>
+#include <random>
+#include <vector>
+#include <Eigen/Dense>
+
+namespace Sim{
+
+    /**
+     * @brief Mean wind against altitude, resampled from a table of layers onto a uniform grid so lookups are O(1)
+     * the wind is linear between layers and held at the lowest and highest layer outside them
+     */
+    class WindProfile{
+        private:
+            double _zMin;
+            double _spacing;
+            double _invSpacing;
+            // one column per grid point, the wind velocity at _zMin + i*_spacing
+            Eigen::Matrix3Xd _velocities;
+
+            WindProfile(const std::vector<double>& altitudes, const std::vector<Eigen::Vector3d>& velocities, double spacing);
+
+        public:
+            /**
+             * @brief Creates a profile from a wind table
+             *
+             * @param altitudes altitude of each layer in meters, strictly increasing
+             * @param velocities wind velocity at each layer in the global frame, the direction the air moves
+             * @param spacing grid spacing in meters, the table is exact at layers that fall on the grid
+             * @return std::shared_ptr<const WindProfile>
+             */
+            static std::shared_ptr<const WindProfile> create(
+                const std::vector<double>& altitudes, const std::vector<Eigen::Vector3d>& velocities, double spacing = 10
+                );
+
+            // the same wind at every altitude
+            static std::shared_ptr<const WindProfile> constant(const Eigen::Vector3d& velocity);
+
+            Eigen::Vector3d at(double altitude) const;
+    };
+
+    /**
+     * @brief Settings for the gusts laid over the mean wind
+     * each axis is the first order Dryden form, an exponentially correlated random sequence with the given rms and
+     * correlation length, turned into time with the frozen field assumption at a reference airspeed
+     */
+    struct TurbulenceSettings{
+        Eigen::Vector3d intensity = Eigen::Vector3d::Zero(); // rms gust velocity along each global axis in m/s
+        Eigen::Vector3d lengthScale = {200, 200, 50}; // correlation length along each axis in meters
+        double airspeed = 50; // speed the rocket is taken to cross the field at in m/s
+        double duration = 600; // length of the generated sequence in seconds, the last gust is held after it
+        double sampleInterval = 0.01; // seconds between generated samples
+
+        inline bool enabled() const { return (intensity.array() > 0).any(); }
+    };
+
+    // mixed into a run's seed for its gusts so they are a stream of their own, a Sim and a BatchSim lane with the same seed draw the same gusts
+    constexpr std::mt19937_64::result_type TURBULENCE_SEED_SALT = 0x9e3779b97f4a7c15;
+
+    /**
+     * @brief One gust realization, generated ahead of time as a filtered noise sequence and linearly interpolated in time
+     */
+    class Turbulence{
+        private:
+            double _interval;
+            double _invInterval;
+            Eigen::Matrix3Xd _gusts; // one column per sample
+
+            Turbulence(const TurbulenceSettings& settings, std::mt19937_64& rng);
+
+        public:
+            /**
+             * @brief Generates a gust sequence
+             *
+             * @param settings the spectrum and length of the sequence
+             * @param seed seeds the noise so a run and its gusts can be reproduced
+             * @return std::shared_ptr<const Turbulence>
+             */
+            static std::shared_ptr<const Turbulence> generate(const TurbulenceSettings& settings, std::mt19937_64::result_type seed);
+
+            Eigen::Vector3d at(double time) const;
+
+            inline double duration() const { return (_gusts.cols() - 1)*_interval; }
+    };
+}
+
+#endif
@@ -0,0 +1,86 @@
+#include "check.hpp"
+#include "batchSim.hpp"
+#include "simulation.hpp"
+#include "RealAtmos.hpp"
+#include <fmt/core.h>
+#include <array>
+#include <cmath>
+
+/**
+ * @brief A unit mass that burns for a second and then coasts, with drag but no moments so it flies straight up and down
+ * the drag goes through the density and viscosity, so the flight depends on every atmospheric property a lane looks up
+ */
+class Dart : public Sim::RocketInterface{
+    public:
+        virtual Eigen::Vector3d thisWayUp() override { return Eigen::Vector3d{0, 0, 1}; }
+        virtual Eigen::Vector3d cm(const Sim::FlightState& state) override { return Eigen::Vector3d::Zero(); }
+        virtual Eigen::Matrix3d inertia(const Sim::FlightState& state) override { return Eigen::Matrix3d::Identity(); }
+        virtual double mass(const Sim::FlightState& state) override { return 1; }
+        virtual Eigen::Vector3d thrust(const Sim::FlightState& state) override {
+            return state.time() < 1 ? Eigen::Vector3d{0, 0, 60} : Eigen::Vector3d::Zero();
+        }
+        virtual Eigen::Vector3d thrustPosition(const Sim::FlightState& state) override { return Eigen::Vector3d::Zero(); }
+        virtual double referenceArea(const Sim::FlightState& state) override { return 0.002; }
+        virtual double referenceLength(const Sim::FlightState& state) override { return 0.05; }
+        virtual double c_n(const Sim::FlightState& state) override { return 0; }
+        virtual double c_m(const Sim::FlightState& state) override { return 0; }
+        virtual Eigen::Vector3d cp(const Sim::FlightState& state) override { return Eigen::Vector3d::Zero(); }
+        virtual double c_m_damp_pitch(const Sim::FlightState& state) override { return 0; }
+        virtual double c_m_damp_yaw(const Sim::FlightState& state) override { return 0; }
+        // skin friction falls with the reynolds number as it does for a real body
+        virtual double Cdf(const Sim::FlightState& state) override { return 0.074/std::pow(std::max(state.reL(), 1e3), 0.2); }
+        virtual double Cdp(const Sim::FlightState& state) override { return 0.3; }
+        virtual double Cdb(const Sim::FlightState& state) override { return 0.1; }
+};
+
+int main(){
+    // the fused array form matches the scalar form both in the lower atmosphere and off it, where it falls back to the scalar path
+    RealAtmos::RealAtmos* atmos = RealAtmos::RealAtmos::GetInstance();
+    const Eigen::Array4d altitudes{-6e3, 0, 30e3, 90e3};
+    RealAtmos::AtmosPropertiesArray<4> fused;
+    atmos->properties(altitudes, fused);
+    for(int i = 0; i < 4; i++){
+        const RealAtmos::AtmosProperties scalar = atmos->properties(altitudes[i]);
+        auto close = [](double a, double b){
+            return std::abs(a - b) <= 1e-12*std::abs(b);
+        };
+        if(!(close(fused.temperature[i], scalar.temperature) && close(fused.pressure[i], scalar.pressure) && close(fused.density[i], scalar.density)
+            && close(fused.g[i], scalar.g) && close(fused.sound[i], scalar.sound) && close(fused.dynamic_viscosity[i], scalar.dynamic_viscosity)
+            && close(fused.kinematic_viscosity[i], scalar.kinematic_viscosity))){
+            fmt::print("the fused array properties differ from the scalar ones at {} m\n", altitudes[i]);
+            Tests::failures++;
+        }
+    }
+
+    // every lane flies the flight a Sim with the same seed and rod flies, whatever it is batched with
+    std::array<Dart, 4> rockets;
+    auto batch = Sim::BatchSim<4>::create({ &rockets[0], &rockets[1], &rockets[2], &rockets[3] }, 0.01);
+    for(int l = 0; l < 4; l++){
+        batch->setSeed(l, 100 + l);
+        batch->setRodLen(l, 1 + l);
+    }
+    Sim::BatchSim<4>::BatchState initialConditions;
+    for(int l = 0; l < 4; l++){
+        initialConditions.col(l) = Sim::defaultStateVector();
+    }
+    batch->solve(initialConditions);
+
+    for(int l = 0; l < 4; l++){
+        Dart rocket;
+        auto sim = Sim::Sim::create(&rocket, 0.01, "");
+        sim->setVerbose(false);
+        sim->setSummaryOnly(true);
+        sim->setSeed(100 + l);
+        sim->setRodLen(1 + l);
+        sim->solve(Sim::defaultStateVector());
+
+        const Sim::FlightSummary& lane = batch->summary(l);
+        const Sim::FlightSummary& single = sim->summary();
+        if(!(std::abs(lane.apogee - single.apogee) <= 1e-12*single.apogee && lane.steps == single.steps)){
+            fmt::print("lane {} reached {} m in {} steps, the sim reached {} m in {} steps\n", l, lane.apogee, lane.steps, single.apogee, single.steps);
+            Tests::failures++;
+        }
+    }
+
+    return Tests::summary("batch");
+}
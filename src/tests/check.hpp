@@ -0,0 +1,36 @@
+#ifndef TEST_CHECK_H_
+#define TEST_CHECK_H_
+
+#include <fmt/core.h>
+
+namespace Tests{
+
+    // each check prints what failed and the test fails at the end if any did
+    inline int failures = 0;
+
+    /**
+     * @brief Prints how the test's checks went
+     *
+     * @param name what was checked, printed when every check passed
+     * @return int the test's exit code
+     */
+    inline int summary(const char* name){
+        if(failures > 0){
+            fmt::print("{} checks failed\n", failures);
+            return 1;
+        }
+        fmt::print("all {} checks passed\n", name);
+        return 0;
+    }
+}
+
+// a single statement, so it is safe in an unbraced if/else and needs its semicolon
+#define CHECK(condition) \
+    do{ \
+        if(!(condition)){ \
+            fmt::print("{}:{}: check failed: {}\n", __FILE__, __LINE__, #condition); \
+            Tests::failures++; \
+        } \
+    } while(0)
+
+#endif
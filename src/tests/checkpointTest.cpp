@@ -0,0 +1,124 @@
+#include "check.hpp"
+#include "simulation.hpp"
+#include <fmt/core.h>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+/**
+ * @brief A unit mass that thrusts straight up until it first reaches a mach number, with no aerodynamics
+ * nothing it gives depends on the time, so a flight from a state is the same whenever it starts
+ */
+class Sprinter : public Sim::RocketInterface{
+    private:
+        double _thrust;
+        bool _burnt = false;
+
+    public:
+        Sprinter(double thrust) : _thrust(thrust) {}
+
+        virtual Eigen::Vector3d thisWayUp() override { return Eigen::Vector3d{0, 0, 1}; }
+        virtual Eigen::Vector3d cm(const Sim::FlightState& state) override { return Eigen::Vector3d::Zero(); }
+        virtual Eigen::Matrix3d inertia(const Sim::FlightState& state) override { return Eigen::Matrix3d::Identity(); }
+        virtual double mass(const Sim::FlightState& state) override { return 1; }
+        // the burn ends for good once it is fast enough, otherwise it would relight as it slows
+        virtual Eigen::Vector3d thrust(const Sim::FlightState& state) override {
+            _burnt = _burnt || state.mach() >= 0.1;
+            return _burnt ? Eigen::Vector3d::Zero() : Eigen::Vector3d{0, 0, _thrust};
+        }
+        virtual Eigen::Vector3d thrustPosition(const Sim::FlightState& state) override { return Eigen::Vector3d::Zero(); }
+        virtual double referenceArea(const Sim::FlightState& state) override { return 0; }
+        virtual double referenceLength(const Sim::FlightState& state) override { return 0; }
+        virtual double c_n(const Sim::FlightState& state) override { return 0; }
+        virtual double c_m(const Sim::FlightState& state) override { return 0; }
+        virtual Eigen::Vector3d cp(const Sim::FlightState& state) override { return Eigen::Vector3d::Zero(); }
+        virtual double c_m_damp_pitch(const Sim::FlightState& state) override { return 0; }
+        virtual double c_m_damp_yaw(const Sim::FlightState& state) override { return 0; }
+        virtual double Cdf(const Sim::FlightState& state) override { return 0; }
+        virtual double Cdp(const Sim::FlightState& state) override { return 0; }
+        virtual double Cdb(const Sim::FlightState& state) override { return 0; }
+};
+
+static std::shared_ptr<Sim::Sim> makeSim(Sim::RocketInterface* rocket){
+    auto sim = Sim::Sim::create(rocket, 0.01, "");
+    sim->setVerbose(false);
+    sim->setSummaryOnly(true);
+    // the rocket is still on the rod and accelerating up it at the checkpoint, where the phase flags change nothing
+    // so a fresh solve from its state flies as the rest of the flight does
+    sim->setRodLen(10);
+    sim->setTabulateMass(false);
+    sim->setSeed(7);
+    return sim;
+}
+
+int main(){
+    Sprinter parent(30);
+    auto parentSim = makeSim(&parent);
+    parentSim->setCheckpointTime(0.5);
+    parentSim->solve(Sim::StateArray::Zero());
+    CHECK(parentSim->checkpoint().has_value());
+    const Sim::Checkpoint checkpoint = *parentSim->checkpoint();
+    CHECK(checkpoint.onRod);
+
+    // resuming with the same rocket carries on the original flight exactly, once it is ready to burn again
+    parent = Sprinter(30);
+    auto resumed = makeSim(&parent);
+    resumed->resume(checkpoint);
+    CHECK(resumed->summary().apogee == parentSim->summary().apogee);
+    CHECK(resumed->summary().flightTime == parentSim->summary().flightTime);
+
+    // a fork onto another rocket flies as that rocket would from the checkpoint, not from the parent's forces
+    for(bool reseed : { false, true }){
+        Sprinter child(20);
+        auto fork = makeSim(&child);
+        fork->resume(checkpoint, reseed);
+        Sprinter twin(20);
+        auto fresh = makeSim(&twin);
+        fresh->solve(Sim::Sim::externalState(checkpoint));
+
+        const Sim::FlightSummary& forked = fork->summary();
+        const Sim::FlightSummary& started = fresh->summary();
+        if(!(std::abs(forked.apogee - started.apogee) < 1e-6 && std::abs(forked.apogeeTime - checkpoint.time - started.apogeeTime) < 1e-6
+            && std::abs(forked.flightTime - checkpoint.time - started.flightTime) < 1e-6)){
+            fmt::print("fork with reseed {} reached {} m at {} s and landed at {} s, a fresh flight reached {} m at {} s and landed at {} s\n",
+                reseed, forked.apogee, forked.apogeeTime - checkpoint.time, forked.flightTime - checkpoint.time,
+                started.apogee, started.apogeeTime, started.flightTime);
+            Tests::failures++;
+        }
+        CHECK(std::abs(forked.apogee - parentSim->summary().apogee) > 1);
+    }
+
+    // a saved checkpoint loads back, and one with any field out of range is rejected rather than resumed from
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "farseer_checkpoint_test.bin";
+    checkpoint.save(path);
+    const auto loaded = Sim::Checkpoint::load(path);
+    CHECK(loaded.has_value() && loaded->state.isApprox(checkpoint.state) && loaded->abmOrder == checkpoint.abmOrder);
+
+    Sim::Checkpoint corrupt = checkpoint;
+    corrupt.abmOrder = 99;
+    corrupt.save(path);
+    CHECK(!Sim::Checkpoint::load(path).has_value());
+
+    corrupt = checkpoint;
+    corrupt.integrator = Sim::EULER;
+    corrupt.save(path);
+    CHECK(!Sim::Checkpoint::load(path).has_value());
+
+    corrupt = checkpoint;
+    corrupt.attitudeRepresentation = 2;
+    corrupt.save(path);
+    CHECK(!Sim::Checkpoint::load(path).has_value());
+
+    // onRod is the byte after the header, the flight state and the counters
+    checkpoint.save(path);
+    {
+        const std::streamoff onRodOffset = 20 + 2*sizeof(double) + 2*sizeof(Sim::StateArray) + sizeof(Sim::StepData) + sizeof(int) + sizeof(int64_t);
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(onRodOffset);
+        file.put(2);
+    }
+    CHECK(!Sim::Checkpoint::load(path).has_value());
+    std::filesystem::remove(path);
+
+    return Tests::summary("checkpoint");
+}
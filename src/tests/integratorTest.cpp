@@ -0,0 +1,171 @@
+#include "check.hpp"
+#include "referenceRocket.hpp"
+#include "simulation.hpp"
+#include "RealAtmos.hpp"
+#include <fmt/core.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <numbers>
+
+/**
+ * @brief A unit mass with no thrust and no aerodynamics, so it only feels gravity
+ */
+class Ballistic : public Sim::RocketInterface{
+    public:
+        virtual Eigen::Vector3d thisWayUp() override { return Eigen::Vector3d{0, 0, 1}; }
+        virtual Eigen::Vector3d cm(const Sim::FlightState& state) override { return Eigen::Vector3d::Zero(); }
+        virtual Eigen::Matrix3d inertia(const Sim::FlightState& state) override { return Eigen::Matrix3d::Identity(); }
+        virtual double mass(const Sim::FlightState& state) override { return 1; }
+        virtual Eigen::Vector3d thrust(const Sim::FlightState& state) override { return Eigen::Vector3d::Zero(); }
+        virtual Eigen::Vector3d thrustPosition(const Sim::FlightState& state) override { return Eigen::Vector3d::Zero(); }
+        virtual double referenceArea(const Sim::FlightState& state) override { return 0; }
+        virtual double referenceLength(const Sim::FlightState& state) override { return 0; }
+        virtual double c_n(const Sim::FlightState& state) override { return 0; }
+        virtual double c_m(const Sim::FlightState& state) override { return 0; }
+        virtual Eigen::Vector3d cp(const Sim::FlightState& state) override { return Eigen::Vector3d::Zero(); }
+        virtual double c_m_damp_pitch(const Sim::FlightState& state) override { return 0; }
+        virtual double c_m_damp_yaw(const Sim::FlightState& state) override { return 0; }
+        virtual double Cdf(const Sim::FlightState& state) override { return 0; }
+        virtual double Cdp(const Sim::FlightState& state) override { return 0; }
+        virtual double Cdb(const Sim::FlightState& state) override { return 0; }
+};
+
+/**
+ * @brief The reference rocket, counting the sim's derivative evaluations as each asks it for one snapshot
+ */
+class CountingRocket : public Bench::ReferenceRocket{
+    public:
+        long evaluations = 0;
+
+        virtual Sim::RocketSnapshot evaluate(const Sim::FlightState& state, bool massProperties) override {
+            evaluations++;
+            return Bench::ReferenceRocket::evaluate(state, massProperties);
+        }
+};
+
+// how far the flown trajectory is from the closed form one
+struct Errors{
+    double apogee;
+    double apogeeTime;
+    double flightTime;
+    double landing;
+
+    double max() const { return std::max({ std::abs(apogee), std::abs(apogeeTime), std::abs(flightTime), std::abs(landing) }); }
+};
+
+static const double LAUNCH_SPEED = 40;
+
+// straight up from the surface, gravity falls off with the square of the distance from the center of the earth
+// so the flight is a radial kepler orbit: energy gives the apogee and the time to it is
+// sqrt(a^3/mu)*(d + sin(d)), where a is half the apogee radius and sin(d/2)^2 is the apogee height over the apogee radius.
+// with nothing else acting the fall mirrors the climb, so it lands at twice the apogee time
+static Errors fly(Sim::IntegrationStrats integrator, double tolerance, Sim::AttitudeRepresentations attitude = Sim::EULER_ANGLES){
+    const double r0 = RealAtmos::R_0;
+    const double mu = RealAtmos::RealAtmos::GetInstance()->g(0)*r0*r0;
+    const double k = LAUNCH_SPEED*LAUNCH_SPEED*r0/(2*mu);
+    const double apogee = r0*k/(1 - k);
+    const double a = (r0 + apogee)/2;
+    const double d = 2*std::asin(std::sqrt(apogee/(r0 + apogee)));
+    const double apogeeTime = std::sqrt(a*a*a/mu)*(d + std::sin(d));
+
+    Ballistic rocket;
+    auto sim = Sim::Sim::create(&rocket, 0.01, "");
+    sim->setVerbose(false);
+    sim->setSummaryOnly(true);
+    // the sim holds the rocket to the rod until it leaves, so the rod is kept too short to matter
+    sim->setRodLen(1e-9);
+    sim->setIntegrator(integrator);
+    sim->setAttitudeRepresentation(attitude);
+    sim->setTolerances(Sim::StateArray::Constant(tolerance), Sim::StateArray::Constant(tolerance));
+    Sim::StateArray initialConditions = Sim::StateArray::Zero();
+    initialConditions[Sim::Zv] = LAUNCH_SPEED;
+    sim->solve(initialConditions);
+
+    const Sim::FlightSummary& summary = sim->summary();
+    return { summary.apogee - apogee, summary.apogeeTime - apogeeTime, summary.flightTime - 2*apogeeTime, summary.landingPosition.z() };
+}
+
+int main(){
+    // every integrator meets the closed form with either attitude representation, the event times are located on the steps' interpolants
+    for(auto attitude : { Sim::EULER_ANGLES, Sim::QUATERNION }){
+        for(auto integrator : { Sim::RK4, Sim::AB, Sim::DP45, Sim::ABM }){
+            const Errors errors = fly(integrator, 1e-8, attitude);
+            if(!(std::abs(errors.apogee) < 1e-6 && std::abs(errors.apogeeTime) < 1e-6 && std::abs(errors.flightTime) < 1e-6 && std::abs(errors.landing) < 1e-5)){
+                fmt::print("integrator {} with attitude {} is off the closed form by apogee {} m at {} s, landing {} m at {} s\n",
+                    (int)integrator, (int)attitude, errors.apogee, errors.apogeeTime, errors.landing, errors.flightTime);
+                Tests::failures++;
+            }
+        }
+    }
+
+    // a spin of several turns folds the quaternion back into its reference many times, the angles given back never jump across a fold.
+    // with a unit inertia nothing changes the body rates, about an axis tilted off z so every angle moves and none nears gimbal lock
+    {
+        Ballistic rocket;
+        auto sim = Sim::Sim::create(&rocket, 0.01, "");
+        sim->setVerbose(false);
+        sim->setRodLen(1e-9);
+        sim->setAttitudeRepresentation(Sim::QUATERNION);
+        sim->setRecordTrajectory(true);
+        Sim::StateArray initialConditions = Sim::StateArray::Zero();
+        initialConditions[Sim::Zv] = LAUNCH_SPEED;
+        initialConditions[Sim::dPhi] = 0.3;
+        initialConditions[Sim::dPsi] = 3;
+        sim->solve(initialConditions);
+
+        const Sim::Trajectory& trajectory = sim->trajectory();
+        CHECK(trajectory.size() > 2);
+        double largestJump = 0;
+        double turned = 0;
+        for(auto angle : { Sim::Phi, Sim::Theta, Sim::Psi }){
+            const auto angles = trajectory.state(angle);
+            double total = 0;
+            for(Eigen::Index i = 1; i < angles.size(); i++){
+                // the angles are wrapped, so a step across +-pi is the short way round
+                const double jump = std::remainder(angles[i] - angles[i - 1], 2*std::numbers::pi);
+                largestJump = std::max(largestJump, std::abs(jump));
+                total += jump;
+            }
+            turned = std::max(turned, std::abs(total));
+        }
+        // past 60 degrees the vector part is over ATTITUDE_REBASE, so turning several times that rebased many times
+        CHECK(turned > 4*std::numbers::pi);
+        if(!(largestJump < 0.2)){
+            fmt::print("the spinning flight's angles jumped {} rad in one step\n", largestJump);
+            Tests::failures++;
+        }
+    }
+
+    // the adaptive integrators get closer as the tolerance is tightened
+    for(auto integrator : { Sim::DP45, Sim::ABM }){
+        const Errors loose = fly(integrator, 1e-4);
+        const Errors tight = fly(integrator, 1e-8);
+        CHECK(tight.max() <= loose.max());
+        CHECK(tight.max() < 1e-6);
+    }
+
+    // a flight with thrust, drag and damping through the rail exit, takeoff and burnout switches lands in far fewer steps than the limit
+    std::map<Sim::IntegrationStrats, long> evaluations;
+    for(auto integrator : { Sim::RK4, Sim::AB, Sim::DP45, Sim::ABM }){
+        CountingRocket rocket;
+        auto sim = Sim::Sim::create(&rocket, 0.01, "");
+        sim->setVerbose(false);
+        sim->setSummaryOnly(true);
+        sim->setIntegrator(integrator);
+        sim->solve(Sim::defaultStateVector());
+        if(!sim->events().fired(Sim::Events::GroundImpact) || sim->summary().stepLimited || sim->summary().steps >= Sim::Sim::MAX_STEPS/4){
+            fmt::print("integrator {} flew the reference rocket for {} steps to t = {} s without landing cleanly\n",
+                (int)integrator, sim->summary().steps, sim->summary().flightTime);
+            Tests::failures++;
+        }
+        evaluations[integrator] = rocket.evaluations;
+    }
+    // at the default tolerances the adaptive integrators are cheaper than RK4's fixed heuristics,
+    // and AB is wherever the heuristics hold the step steady
+    CHECK(evaluations[Sim::AB] < evaluations[Sim::RK4]);
+    CHECK(evaluations[Sim::DP45] < evaluations[Sim::RK4]);
+    CHECK(evaluations[Sim::ABM] < evaluations[Sim::RK4]);
+
+    return Tests::summary("integrator");
+}
@@ -0,0 +1,74 @@
+#include "testComponents.hpp"
+#include "check.hpp"
+#include "compiledRocket.hpp"
+#include <fmt/core.h>
+#include <memory>
+#include <string>
+
+int main(){
+    Tests::registerTestComponents();
+    auto design = Tests::testRocket();
+    const json original = design->toJson();
+
+    // the tube goes through BodyTube's binary properties and the fins and motor through the CBOR fallback
+    const std::string snapshot = design->toSnapshot();
+    auto loaded = Rocket::componentFromSnapshot(snapshot);
+    CHECK(loaded != nullptr);
+    if(loaded){
+        CHECK(loaded->toJson() == original);
+        CHECK(dynamic_cast<Tests::TestTube*>(loaded.get()) != nullptr);
+        CHECK(loaded->components().size() == 2);
+        const FlightState state(1, 0.3, 0.05, 0.1, 0.1, 2e6);
+        // Component's own flight functions are stubs, the compiled tree gives the values the sim flies
+        const Sim::RocketSnapshot flown = Rocket::CompiledRocket::compile(loaded)->evaluate(state, true);
+        const Sim::RocketSnapshot expected = Rocket::CompiledRocket::compile(design)->evaluate(state, true);
+        CHECK(expected.mass > 0);
+        CHECK(flown.mass == expected.mass);
+        CHECK(flown.cm == expected.cm);
+        CHECK(flown.inertia == expected.inertia);
+        CHECK(expected.c_n != 0);
+        CHECK(flown.c_n == expected.c_n);
+        CHECK(flown.cp == expected.cp);
+        CHECK(flown.Cdf == expected.Cdf);
+        CHECK(flown.Cdp == expected.Cdp);
+        CHECK(flown.Cdb == expected.Cdb);
+        // a snapshot of the loaded tree is the same bytes
+        CHECK(loaded->toSnapshot() == snapshot);
+    }
+
+    // the json loader builds the same tree
+    auto fromJson = Rocket::componentFromJson(original);
+    CHECK(fromJson != nullptr);
+    if(fromJson){
+        CHECK(fromJson->toJson() == original);
+    }
+
+    // every truncation is rejected rather than read past the end
+    for(size_t length = 0; length < snapshot.size(); length++){
+        if(Rocket::componentFromSnapshot(std::string_view(snapshot).substr(0, length)) != nullptr){
+            fmt::print("a snapshot truncated to {} of {} bytes loaded\n", length, snapshot.size());
+            Tests::failures++;
+        }
+    }
+
+    // other files and other versions are rejected
+    std::string badMagic = snapshot;
+    badMagic[0] = 'X';
+    CHECK(Rocket::componentFromSnapshot(badMagic) == nullptr);
+    std::string badVersion = snapshot;
+    badVersion[sizeof(Rocket::SNAPSHOT::MAGIC)] += 1;
+    CHECK(Rocket::componentFromSnapshot(badVersion) == nullptr);
+    CHECK(Rocket::componentFromSnapshot(std::string_view{}) == nullptr);
+
+    // the tube's fill flag is the byte after its height, diameter and thickness, anything but 0 or 1 is rejected
+    const double dimensions[] = { 1.2, 0.075, 0.002 };
+    const size_t tube = snapshot.find(std::string_view(reinterpret_cast<const char*>(dimensions), sizeof(dimensions)));
+    CHECK(tube != std::string::npos);
+    if(tube != std::string::npos){
+        std::string badFlag = snapshot;
+        badFlag[tube + sizeof(dimensions)] = 2;
+        CHECK(Rocket::componentFromSnapshot(badFlag) == nullptr);
+    }
+
+    return Tests::summary("snapshot");
+}
@@ -0,0 +1,76 @@
+#include "testComponents.hpp"
+#include "check.hpp"
+#include "sweep.hpp"
+#include "stateArray.hpp"
+#include <fmt/core.h>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+
+int main(){
+    auto design = Tests::testRocket();
+    std::shared_ptr<Rocket::Component> fins = design->components()[0];
+    Sim::StateArray initialConditions = Sim::StateArray::Zero();
+    initialConditions[Sim::Theta] = 0.05;
+    const std::vector<Rocket::SweepParameter> parameters = {
+        { fins->id(), "span", {0.03, 0.05, 0.07} },
+        { fins->id(), "fin_mass", {0.01, 0.04} }
+    };
+
+    // nothing is registered yet so componentFromJson cannot build the design
+    bool threw = false;
+    try{
+        Rocket::Sweep::create(design, parameters, initialConditions, 0.01);
+    } catch(const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    Tests::registerTestComponents();
+    auto sweep = Rocket::Sweep::create(design, parameters, initialConditions, 0.01);
+    const std::vector<Rocket::SweepMetric> metrics = {
+        Rocket::SweepMetric::Apogee, Rocket::SweepMetric::BurnoutTime, Rocket::SweepMetric::MaxMach, Rocket::SweepMetric::LandingX
+    };
+    const Rocket::SweepResults results = sweep->run(metrics, 2);
+
+    CHECK(results.size() == 6);
+    CHECK(results.columns.size() == 6);
+    for(size_t i = 0; i < results.size(); i++){
+        if(results.failed(i)){
+            fmt::print("point {} failed: {}\n", i, results.errors[i]);
+            Tests::failures++;
+            continue;
+        }
+        CHECK(results.values(i, 2) > 0);
+        CHECK(std::abs(results.values(i, 3) - 1.8) < 1e-6);
+        CHECK(results.values(i, 4) > 0);
+        // only set once the flight is on the ground
+        CHECK(std::isfinite(results.values(i, 5)));
+    }
+    // the last parameter varies fastest, heavier fins fly lower at every span
+    for(size_t span = 0; span < 3; span++){
+        CHECK(results.values(2*span, 0) == parameters[0].values[span]);
+        CHECK(results.values(2*span + 1, 2) < results.values(2*span, 2));
+    }
+    // the sims settings reach every point and the kpis the metrics need are tracked even when masked off
+    threw = false;
+    try{
+        sweep->setIntegrator(Sim::EULER);
+    } catch(const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    sweep->setIntegrator(Sim::DP45);
+    sweep->setKpis(Sim::Kpis::KpiMask());
+    const std::vector<Rocket::Sweep::Point> first = { { parameters[0].values[0], parameters[1].values[0] } };
+    const Rocket::SweepResults adaptive = sweep->run(first, metrics, 1);
+    CHECK(!adaptive.failed(0));
+    CHECK(std::abs(adaptive.values(0, 2) - results.values(0, 2)) < 1e-2*results.values(0, 2));
+    CHECK(adaptive.values(0, 4) > 0);
+    CHECK(std::isfinite(adaptive.values(0, 5)));
+
+    // each point builds its own tree, the base design is untouched
+    CHECK(design->toJson() == Tests::testRocket()->toJson());
+
+    return Tests::summary("sweep");
+}
@@ -0,0 +1,169 @@
+#ifndef TEST_COMPONENTS_H_
+#define TEST_COMPONENTS_H_
+
+#include "components/component.hpp"
+#include "components/bodyTube.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <numbers>
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+
+namespace Tests{
+
+    /**
+     * @brief A body tube with closed form flight values, BodyTube leaves them to its subclasses
+     * it keeps BodyTube's properties so it loads through BodyTube's binary snapshot form
+     */
+    class TestTube : public Rocket::BodyTube{
+        protected:
+            virtual double mass_this(const FlightState& state) override {
+                return getMaterial()->getDensity()*std::numbers::pi*getDiameter()*getThickness()*getHeight();
+            }
+            virtual Eigen::Vector3d cm_this(const FlightState& state) override { return Eigen::Vector3d{getHeight()/2, 0, 0}; }
+            virtual Eigen::Matrix3d inertia_this(const FlightState& state) override {
+                const double m = mass_this(state);
+                const double r = getDiameter()/2;
+                const double lateral = m*(6*r*r + getHeight()*getHeight())/12;
+                return Eigen::Vector3d{m*r*r, lateral, lateral}.asDiagonal();
+            }
+            virtual double referenceArea_this(const FlightState& state) override { return std::numbers::pi*getDiameter()*getDiameter()/4; }
+            virtual double referenceLength_this(const FlightState& state) override { return getDiameter(); }
+            // the nose is folded into the tube, its normal force acts near the front
+            virtual double c_n_this(const FlightState& state) override { return 2*std::sin(state.alpha()); }
+            virtual double c_m_this(const FlightState& state) override { return 0; }
+            virtual Eigen::Vector3d cp_this(const FlightState& state) override { return Eigen::Vector3d{0.15*getHeight(), 0, 0}; }
+            virtual double c_m_damp_pitch_this(const FlightState& state) override { return 0.5*std::abs(state.pitchVel()); }
+            virtual double c_m_damp_yaw_this(const FlightState& state) override { return 0.5*std::abs(state.yawVel()); }
+            virtual double Cdf_this(const FlightState& state) override { return 0.25; }
+            virtual double Cdp_this(const FlightState& state) override { return 0.1 + 0.1*state.mach()*state.mach(); }
+            virtual double Cdb_this(const FlightState& state) override { return 0.1; }
+
+        public:
+            TestTube(double height = 0, double diameter = 0, double thickness = 0, std::string name = "", Eigen::Vector3d position = Eigen::Vector3d::Zero()) :
+                Rocket::BodyTube(height, diameter, thickness, false, name, position, std::make_unique<Material>("Cardboard", 1250)) {}
+    };
+
+    /**
+     * @brief A set of flat fins stored through the default CBOR snapshot properties
+     */
+    class TestFins : public Rocket::Component{
+        private:
+            int _count = 0;
+            double _span = 0;
+            double _chord = 0;
+            double _finMass = 0;
+
+        protected:
+            virtual json propertiesToJson() override {
+                return json{ {"count", _count}, {"span", _span}, {"chord", _chord}, {"fin_mass", _finMass} };
+            }
+            virtual void jsonToProperties(json j) override {
+                json properties = j.at("properties");
+                _count = properties.at("count");
+                _span = properties.at("span");
+                _chord = properties.at("chord");
+                _finMass = properties.at("fin_mass");
+            }
+
+            virtual double mass_this(const FlightState& state) override { return _count*_finMass; }
+            virtual Eigen::Vector3d cm_this(const FlightState& state) override { return Eigen::Vector3d{_chord/2, 0, 0}; }
+            virtual Eigen::Matrix3d inertia_this(const FlightState& state) override {
+                const double m = mass_this(state);
+                return Eigen::Vector3d{m*_span*_span/2, m*_chord*_chord/12, m*_chord*_chord/12}.asDiagonal();
+            }
+            // referenced to one fin's planform
+            virtual double referenceArea_this(const FlightState& state) override { return _span*_chord; }
+            virtual double referenceLength_this(const FlightState& state) override { return _chord; }
+            virtual double c_n_this(const FlightState& state) override { return _count*std::sin(state.alpha()); }
+            virtual double c_m_this(const FlightState& state) override { return 0; }
+            virtual Eigen::Vector3d cp_this(const FlightState& state) override { return Eigen::Vector3d{_chord/2, 0, 0}; }
+            virtual double c_m_damp_pitch_this(const FlightState& state) override { return 0.2*_count*std::abs(state.pitchVel()); }
+            virtual double c_m_damp_yaw_this(const FlightState& state) override { return 0.2*_count*std::abs(state.yawVel()); }
+            virtual double Cdf_this(const FlightState& state) override { return 0.02*_count; }
+            virtual double Cdp_this(const FlightState& state) override { return 0.01*_count; }
+            virtual double Cdb_this(const FlightState& state) override { return 0; }
+
+        public:
+            TestFins(int count = 0, double span = 0, double chord = 0, double finMass = 0, std::string name = "", Eigen::Vector3d position = Eigen::Vector3d::Zero()) :
+                Component(name, position), _count(count), _span(span), _chord(chord), _finMass(finMass) {}
+
+            virtual std::string type() override { return Rocket::COMPONENT_NAMES::FIN_SET; }
+            virtual std::vector<std::string> allowedComponents() override { return {}; }
+    };
+
+    /**
+     * @brief A motor with a constant thrust that burns its propellant evenly, stored through the default CBOR snapshot properties
+     */
+    class TestMotor : public Rocket::Component{
+        private:
+            double _thrust = 0;
+            double _burnTime = 0;
+            double _wetMass = 0;
+            double _dryMass = 0;
+
+            inline double burnt(double time) const { return _burnTime > 0 ? std::clamp(time/_burnTime, 0.0, 1.0) : 1.0; }
+
+        protected:
+            virtual json propertiesToJson() override {
+                return json{ {"thrust", _thrust}, {"burn_time", _burnTime}, {"wet_mass", _wetMass}, {"dry_mass", _dryMass} };
+            }
+            virtual void jsonToProperties(json j) override {
+                json properties = j.at("properties");
+                _thrust = properties.at("thrust");
+                _burnTime = properties.at("burn_time");
+                _wetMass = properties.at("wet_mass");
+                _dryMass = properties.at("dry_mass");
+            }
+
+            virtual double mass_this(const FlightState& state) override { return _wetMass - (_wetMass - _dryMass)*burnt(state.time()); }
+            virtual Eigen::Vector3d cm_this(const FlightState& state) override { return Eigen::Vector3d{0.1, 0, 0}; }
+            virtual Eigen::Matrix3d inertia_this(const FlightState& state) override {
+                const double m = mass_this(state);
+                return Eigen::Vector3d{1e-4*m, 3e-3*m, 3e-3*m}.asDiagonal();
+            }
+            // the rocket points along -x
+            virtual Eigen::Vector3d thrust_this(const FlightState& state) override {
+                return state.time() < _burnTime ? Eigen::Vector3d{-_thrust, 0, 0} : Eigen::Vector3d::Zero();
+            }
+            virtual Eigen::Vector3d thrustPosition_this() override { return Eigen::Vector3d{0.2, 0, 0}; }
+            virtual double referenceArea_this(const FlightState& state) override { return 0; }
+            virtual double referenceLength_this(const FlightState& state) override { return 0; }
+            virtual double c_n_this(const FlightState& state) override { return 0; }
+            virtual double c_m_this(const FlightState& state) override { return 0; }
+            virtual Eigen::Vector3d cp_this(const FlightState& state) override { return Eigen::Vector3d::Zero(); }
+            virtual double c_m_damp_pitch_this(const FlightState& state) override { return 0; }
+            virtual double c_m_damp_yaw_this(const FlightState& state) override { return 0; }
+            virtual double Cdf_this(const FlightState& state) override { return 0; }
+            virtual double Cdp_this(const FlightState& state) override { return 0; }
+            virtual double Cdb_this(const FlightState& state) override { return 0; }
+
+        public:
+            TestMotor(double thrust = 0, double burnTime = 0, double wetMass = 0, double dryMass = 0, std::string name = "", Eigen::Vector3d position = Eigen::Vector3d::Zero()) :
+                Component(name, position), _thrust(thrust), _burnTime(burnTime), _wetMass(wetMass), _dryMass(dryMass) {}
+
+            virtual std::string type() override { return Rocket::COMPONENT_NAMES::MOTOR; }
+            virtual std::vector<std::string> allowedComponents() override { return {}; }
+    };
+
+    // makes the loaders build these in place of the built in types they stand in for
+    inline void registerTestComponents(){
+        Rocket::registerComponentType(Rocket::COMPONENT_NAMES::BODY_TUBE, [](){ return std::make_shared<TestTube>(); });
+        Rocket::registerComponentType(Rocket::COMPONENT_NAMES::FIN_SET, [](){ return std::make_shared<TestFins>(); });
+        Rocket::registerComponentType(Rocket::COMPONENT_NAMES::MOTOR, [](){ return std::make_shared<TestMotor>(); });
+    }
+
+    // a 1.2m, 75mm rocket with four fins and an 80N motor at the back
+    inline std::shared_ptr<TestTube> testRocket(){
+        auto body = std::make_shared<TestTube>(1.2, 0.075, 0.002, "Body");
+        auto fins = std::make_shared<TestFins>(4, 0.05, 0.06, 0.02, "Fins", Eigen::Vector3d{1.14, 0, 0});
+        auto motor = std::make_shared<TestMotor>(80, 1.8, 0.35, 0.2, "Motor", Eigen::Vector3d{1.0, 0, 0});
+        body->addComponent(fins.get());
+        body->addComponent(motor.get());
+        return body;
+    }
+}
+
+#endif